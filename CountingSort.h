@@ -0,0 +1,163 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <vector>
+#include "Quicksort.h"
+
+
+
+// Сортировка подсчетом для целых ключей из небольшого диапазона.
+//
+// Первая волна задач пула ищет минимум и максимум по частям массива. Если диапазон значений
+// не превышает числа элементов, следующие волны строят гистограммы по частям массива,
+// затем суммируют их по отрезкам диапазона значений (заодно получая размер каждого отрезка на выходе)
+// и, после префиксной суммы по отрезкам, заполняют массив: каждый отрезок значений пишет свою часть.
+// Иначе последняя задача первой волны запускает обычную быструю сортировку на том же состоянии,
+// так что лишняя работа для широких диапазонов — один проход чтения.
+
+namespace counting_detail {
+
+constexpr long min_size = 1L << 12;  // Меньшие участки сортируются сравнением
+constexpr long min_chunk = 1L << 16; // Минимальная часть массива на задачу
+
+template <typename T>
+struct CountingState {
+    ThreadPool &pool;
+    std::shared_ptr<QuicksortState> state;
+    T* array;
+    long n;
+    long threshold;
+    long chunks = 1;               // Частей массива для поиска минимума/максимума и гистограмм
+    long pieces = 1;               // Отрезков диапазона значений для суммирования и заполнения
+    std::vector<T> mins, maxs;
+    T lo {};
+    long range = 0;
+    std::vector<uint32_t> hist;    // chunks * range счетчиков; строка 0 после суммирования — итог
+    std::vector<long> piece_start; // Начало каждого отрезка значений на выходе
+    std::atomic<long> remaining {0};
+
+    CountingState(ThreadPool &p, std::shared_ptr<QuicksortState> s) : pool(p), state(std::move(s)) {}
+
+    long chunk_begin(long c) const { return c * n / chunks; }
+    long piece_begin(long p) const { return p * range / pieces; }
+};
+
+// Запустить fn(st, c) для c в [0, count): задача 0 выполняется в текущем потоке
+template <typename T, typename Fn>
+void run_wave(std::shared_ptr<CountingState<T>> st, long count, Fn fn) {
+    st->remaining.store(count);
+    for (long c = 1; c < count; ++c) {
+        spawn_task_in_pool(st->pool, st->state, [st, c, fn]() { fn(st, c); });
+    }
+    fn(st, 0);
+}
+
+template <typename T>
+bool last_of_wave(const std::shared_ptr<CountingState<T>> &st) {
+    return st->remaining.fetch_sub(1, std::memory_order_acq_rel) == 1;
+}
+
+// Заполнение массива значениями отрезка p по итоговым счетчикам
+template <typename T>
+void fill_piece(std::shared_ptr<CountingState<T>> st, long p) {
+    using U = std::make_unsigned_t<T>;
+    const uint32_t* total = st->hist.data();
+    T* out = st->array + st->piece_start[p];
+    for (long v = st->piece_begin(p), end = st->piece_begin(p + 1); v < end; ++v) {
+        out = std::fill_n(out, total[v], T(U(U(st->lo) + U(v))));
+    }
+}
+
+// Суммирование гистограмм частей по отрезку значений p; последняя задача считает начала отрезков
+template <typename T>
+void reduce_piece(std::shared_ptr<CountingState<T>> st, long p) {
+    uint32_t* total = st->hist.data();
+    long sum = 0;
+    for (long v = st->piece_begin(p), end = st->piece_begin(p + 1); v < end; ++v) {
+        uint32_t count = total[v];
+        for (long c = 1; c < st->chunks; ++c) count += total[c * st->range + v];
+        total[v] = count;
+        sum += count;
+    }
+    st->piece_start[p + 1] = sum;
+    if (!last_of_wave(st)) return;
+    for (long q = 0; q < st->pieces; ++q) st->piece_start[q + 1] += st->piece_start[q];
+    run_wave(st, st->pieces, fill_piece<T>);
+}
+
+// Гистограмма части c
+template <typename T>
+void histogram_chunk(std::shared_ptr<CountingState<T>> st, long c) {
+    using U = std::make_unsigned_t<T>;
+    uint32_t* h = st->hist.data() + c * st->range;
+    const U lo = U(st->lo);
+    for (long i = st->chunk_begin(c), end = st->chunk_begin(c + 1); i < end; ++i) {
+        ++h[size_t(U(U(st->array[i]) - lo))];
+    }
+    if (last_of_wave(st)) run_wave(st, st->pieces, reduce_piece<T>);
+}
+
+// Минимум и максимум части c; последняя задача выбирает подсчет или быструю сортировку
+template <typename T>
+void min_max_chunk(std::shared_ptr<CountingState<T>> st, long c) {
+    auto [mn, mx] = std::minmax_element(st->array + st->chunk_begin(c), st->array + st->chunk_begin(c + 1));
+    st->mins[c] = *mn;
+    st->maxs[c] = *mx;
+    if (!last_of_wave(st)) return;
+
+    T lo = *std::min_element(st->mins.begin(), st->mins.end());
+    T hi = *std::max_element(st->maxs.begin(), st->maxs.end());
+    // Ширина диапазона в беззнаковой арифметике, чтобы не было переполнения для знаковых типов
+    using U = std::make_unsigned_t<T>;
+    uint64_t width = uint64_t(U(U(hi) - U(lo)));
+    if (width >= uint64_t(st->n)) {
+        quicksort_job(st->pool, st->array, 0, st->n - 1, st->state, st->threshold);
+        return;
+    }
+    st->lo = lo;
+    st->range = long(width) + 1;
+    // Гистограммы частей занимают не больше 2n счетчиков
+    st->chunks = std::clamp(2 * st->n / st->range, 1L, st->chunks);
+    st->pieces = std::clamp(st->range / min_chunk, 1L, long(st->pool.size()));
+    st->hist.assign(size_t(st->chunks * st->range), 0);
+    st->piece_start.assign(st->pieces + 1, 0);
+    run_wave(st, st->chunks, histogram_chunk<T>);
+}
+
+} // namespace counting_detail
+
+// Сортировка участка [left, right] целых чисел на существующем состоянии (для составных сортировок)
+template <typename T>
+void counting_sort_job(ThreadPool &pool, T* array, long left, long right, std::shared_ptr<QuicksortState> state,
+                       long threshold) {
+    static_assert(std::is_integral_v<T> && !std::is_same_v<T, bool>, "сортировка подсчетом поддерживает только целые типы");
+    using namespace counting_detail;
+    long n = std::max(0L, right - left + 1);
+    // Счетчики 32-битные, поэтому очень большие участки сортируются сравнением
+    if (n < min_size || uint64_t(n) > UINT32_MAX) {
+        quicksort_job(pool, array, left, right, state, threshold);
+        return;
+    }
+    auto st = std::make_shared<CountingState<T>>(pool, std::move(state));
+    st->array = array + left;
+    st->n = n;
+    st->threshold = threshold;
+    st->chunks = std::clamp(n / min_chunk, 1L, long(pool.size()));
+    st->mins.resize(st->chunks);
+    st->maxs.resize(st->chunks);
+    run_wave(st, st->chunks, min_max_chunk<T>);
+}
+
+// Асинхронная сортировка участка [left, right] целых чисел: подсчетом, если диапазон значений
+// не больше числа элементов, иначе — быстрой сортировкой с настройками opts
+template <typename T>
+std::future<void> counting_sort_async(ThreadPool &pool, T* array, long left, long right, long threshold = 100000,
+                                      const QuicksortOptions &opts = {}) {
+    auto state = std::make_shared<QuicksortState>();
+    state->opts = opts;
+    spawn_task_in_pool(pool, state, [=, &pool]() { counting_sort_job(pool, array, left, right, state, threshold); });
+    return state->prom->get_future();
+}
@@ -0,0 +1,275 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <filesystem>
+#include <functional>
+#include <future>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+#include "ThreadPool.h"
+#include "Quicksort.h"
+#include "LoserTree.h"
+
+
+
+// Внешняя сортировка двоичных файлов из элементов фиксированного размера, не помещающихся в память.
+//
+// Этап серий: файл читается частями по половине бюджета памяти в два буфера по очереди. Пока одна
+// часть сортируется быстрой сортировкой на пуле (на месте, без дополнительной памяти), текущий поток
+// записывает предыдущую отсортированную часть во временный файл и читает следующую.
+// Этап слияния: серии сливаются k-путевым слиянием через дерево проигравших (log k сравнений
+// на элемент). Каждая серия читается в два буфера: пока один расходуется, второй заполняется
+// задачей пула; выход тоже пишется двумя буферами. Если серий больше, чем позволяет бюджет памяти,
+// слияние идет в несколько проходов.
+
+// Настройки внешней сортировки
+struct ExternalSortOptions {
+    size_t memory_budget = size_t(1) << 30; // Бюджет памяти на буферы, байт
+    size_t io_buffer = size_t(4) << 20;     // Размер одного буфера чтения/записи при слиянии, байт
+    std::filesystem::path temp_dir = std::filesystem::temp_directory_path(); // Каталог временных серий
+    long threshold = 100000;                // Порог параллельных задач при сортировке частей
+};
+
+namespace external_detail {
+
+// Выполнить fn задачей пула и вернуть future (исключение задачи передается в future)
+template <typename Fn>
+std::future<void> run_async(ThreadPool &pool, Fn fn) {
+    auto state = std::make_shared<QuicksortState>();
+    spawn_task_in_pool(pool, state, std::move(fn));
+    return state->prom->get_future();
+}
+
+// Файл с закрытием в деструкторе
+struct File {
+    std::FILE* f = nullptr;
+
+    File(const std::filesystem::path &path, const char* mode) : f(std::fopen(path.string().c_str(), mode)) {
+        if (!f) throw std::runtime_error("внешняя сортировка: не удалось открыть " + path.string());
+    }
+    File(const File &) = delete;
+    File &operator=(const File &) = delete;
+    ~File() { if (f) std::fclose(f); }
+};
+
+template <typename T>
+long read_elements(std::FILE* f, T* dst, long count) {
+    return long(std::fread(dst, sizeof(T), size_t(count), f));
+}
+
+template <typename T>
+void write_elements(std::FILE* f, const T* src, long count) {
+    if (count > 0 && std::fwrite(src, sizeof(T), size_t(count), f) != size_t(count)) {
+        throw std::runtime_error("внешняя сортировка: ошибка записи");
+    }
+}
+
+// Чтение серии двумя буферами: следующий буфер заполняется задачей пула
+template <typename T>
+class RunReader {
+public:
+    RunReader(ThreadPool &pool, const std::filesystem::path &path, long buffer_elems)
+        : pool_(pool), file_(std::make_unique<File>(path, "rb")) {
+        buf_[0].resize(buffer_elems);
+        buf_[1].resize(buffer_elems);
+        size_[0] = read_elements(file_->f, buf_[0].data(), buffer_elems);
+        if (size_[0] > 0) start_read(1);
+    }
+
+    ~RunReader() {
+        if (pending_.valid()) pending_.wait(); // Буфер не должен освободиться во время чтения
+    }
+
+    bool done() const { return pos_ >= size_[cur_]; }
+    const T &peek() const { return buf_[cur_][pos_]; }
+
+    T pop() {
+        T x = buf_[cur_][pos_++];
+        if (pos_ == size_[cur_]) advance();
+        return x;
+    }
+
+private:
+    void start_read(int b) {
+        T* dst = buf_[b].data();
+        long* size = &size_[b];
+        long count = long(buf_[b].size());
+        std::FILE* f = file_->f;
+        pending_ = run_async(pool_, [f, dst, size, count]() { *size = read_elements(f, dst, count); });
+    }
+
+    void advance() {
+        if (!pending_.valid()) return; // Серия закончилась
+        pending_.get();
+        cur_ ^= 1;
+        pos_ = 0;
+        if (size_[cur_] > 0) start_read(cur_ ^ 1);
+    }
+
+    ThreadPool &pool_;
+    std::unique_ptr<File> file_;
+    std::vector<T> buf_[2];
+    long size_[2] = {0, 0};
+    long pos_ = 0;
+    int cur_ = 0;
+    std::future<void> pending_;
+};
+
+// Запись двумя буферами: заполненный буфер пишется задачей пула, пока заполняется второй
+template <typename T>
+class RunWriter {
+public:
+    RunWriter(ThreadPool &pool, const std::filesystem::path &path, long buffer_elems)
+        : pool_(pool), file_(std::make_unique<File>(path, "wb")), capacity_(buffer_elems) {
+        buf_[0].reserve(capacity_);
+        buf_[1].reserve(capacity_);
+    }
+
+    void push(const T &x) {
+        buf_[cur_].push_back(x);
+        if (long(buf_[cur_].size()) == capacity_) flush();
+    }
+
+    // Дописать остаток и дождаться окончания записи
+    void finish() {
+        flush();
+        if (pending_.valid()) pending_.get();
+    }
+
+    ~RunWriter() {
+        if (pending_.valid()) pending_.wait(); // Буфер не должен освободиться во время записи
+    }
+
+private:
+    void flush() {
+        if (pending_.valid()) pending_.get();
+        std::vector<T>* full = &buf_[cur_];
+        std::FILE* f = file_->f;
+        if (!full->empty()) {
+            pending_ = run_async(pool_, [f, full]() {
+                write_elements(f, full->data(), long(full->size()));
+                full->clear();
+            });
+        }
+        cur_ ^= 1;
+    }
+
+    ThreadPool &pool_;
+    std::unique_ptr<File> file_;
+    long capacity_;
+    std::vector<T> buf_[2];
+    int cur_ = 0;
+    std::future<void> pending_;
+};
+
+// Слить серии inputs в файл output
+template <typename T, typename Compare>
+void merge_runs(ThreadPool &pool, const std::vector<std::filesystem::path> &inputs, const std::filesystem::path &output,
+                long buffer_elems, Compare comp) {
+    std::vector<std::unique_ptr<RunReader<T>>> readers;
+    for (auto &path : inputs) readers.push_back(std::make_unique<RunReader<T>>(pool, path, buffer_elems));
+    RunWriter<T> writer(pool, output, buffer_elems);
+    auto beats = [&](long a, long b) {
+        if (readers[a]->done()) return false;
+        if (readers[b]->done()) return true;
+        return comp(readers[a]->peek(), readers[b]->peek());
+    };
+    LoserTree<decltype(beats)> tree(long(readers.size()), beats);
+    while (!readers[tree.winner()]->done()) {
+        writer.push(readers[tree.winner()]->pop());
+        tree.replay();
+    }
+    writer.finish();
+}
+
+} // namespace external_detail
+
+// Отсортировать файл input из элементов T и записать результат в output (можно тот же путь).
+// Нельзя вызывать из задачи того же пула. Ошибки ввода-вывода — std::runtime_error
+template <typename T, typename Compare = std::less<>>
+void external_sort(const std::filesystem::path &input, const std::filesystem::path &output, ThreadPool &pool,
+                   const ExternalSortOptions &opts = {}, Compare comp = {}) {
+    static_assert(std::is_trivially_copyable_v<T>, "внешняя сортировка работает с элементами фиксированного размера");
+    using namespace external_detail;
+    namespace fs = std::filesystem;
+    if (fs::file_size(input) % sizeof(T) != 0) {
+        throw std::runtime_error("внешняя сортировка: размер файла не кратен размеру элемента");
+    }
+
+    // Уникальные имена временных серий
+    std::string tag = std::to_string(std::random_device{}());
+    long run_counter = 0;
+    std::vector<fs::path> runs;
+    std::vector<fs::path> next; // Серии текущего прохода слияния; при ошибке удаляются вместе с runs
+    auto new_run = [&]() { return opts.temp_dir / ("sort_run_" + tag + "_" + std::to_string(run_counter++) + ".bin"); };
+    auto remove_runs = [](const std::vector<fs::path> &paths) {
+        std::error_code ec;
+        for (auto &p : paths) fs::remove(p, ec);
+    };
+
+    try {
+        // Этап серий: два буфера по половине бюджета
+        long chunk = std::max(1L, long(opts.memory_budget / 2 / sizeof(T)));
+        std::vector<T> buf[2] = {std::vector<T>(chunk), std::vector<T>(chunk)};
+        QuicksortOptions qopts;
+        qopts.kernel = PartitionKernel::Simd;
+        {
+            File in(input, "rb");
+            int cur = 0;
+            long n = read_elements(in.f, buf[cur].data(), chunk);
+            std::future<void> sorting;
+            if (n > 0) sorting = quicksort_async(pool, buf[cur].data(), 0, n - 1, opts.threshold, qopts, comp);
+            try {
+                while (n > 0) {
+                    long next = read_elements(in.f, buf[cur ^ 1].data(), chunk); // Параллельно с сортировкой
+                    sorting.get();
+                    if (next > 0) sorting = quicksort_async(pool, buf[cur ^ 1].data(), 0, next - 1, opts.threshold, qopts, comp);
+                    runs.push_back(new_run());
+                    File out(runs.back(), "wb");
+                    write_elements(out.f, buf[cur].data(), n); // Параллельно с сортировкой следующей части
+                    n = next;
+                    cur ^= 1;
+                }
+            } catch (...) {
+                if (sorting.valid()) sorting.wait(); // Буферы освобождаются только после сортировки
+                throw;
+            }
+        }
+        buf[0] = {};
+        buf[1] = {};
+
+        // Этап слияния: на каждую серию и на выход по два буфера
+        long buffer_elems = std::max(1L, long(opts.io_buffer / sizeof(T)));
+        long fan_in = std::max(2L, long(opts.memory_budget / (2 * opts.io_buffer)) - 1);
+        while (long(runs.size()) > fan_in) {
+            for (size_t i = 0; i < runs.size(); i += size_t(fan_in)) {
+                std::vector<fs::path> group(runs.begin() + i, runs.begin() + std::min(runs.size(), i + size_t(fan_in)));
+                if (group.size() == 1) {
+                    next.push_back(group[0]);
+                    continue;
+                }
+                next.push_back(new_run());
+                merge_runs<T>(pool, group, next.back(), buffer_elems, comp);
+                remove_runs(group);
+            }
+            runs = std::move(next);
+            next.clear();
+        }
+        if (runs.empty()) {
+            File out(output, "wb"); // Пустой вход — пустой выход
+        } else {
+            merge_runs<T>(pool, runs, output, buffer_elems, comp);
+        }
+    } catch (...) {
+        // В next могут быть и уже слитые серии этого прохода, и недописанный выход слияния
+        remove_runs(runs);
+        remove_runs(next);
+        throw;
+    }
+    remove_runs(runs);
+}
@@ -0,0 +1,181 @@
+#pragma once
+#include <algorithm>
+#include <functional>
+#include <future>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <ranges>
+#include <stdexcept>
+#include <vector>
+#include "ThreadPool.h"
+#include "Quicksort.h"
+
+
+
+// Ленивое отсортированное представление массива (инкрементальная быстрая сортировка).
+//
+// Массив делится на участки, разделенные границами опорных элементов: всё левее границы не больше
+// всего правее нее. Для каждого участка помнится, отсортирован ли он. Запрос at(rank) разбивает
+// только участок, содержащий rank, пока rank не окажется на границе (как быстрый выбор), а
+// range(lo, hi) делает границами lo и hi и сортирует лишь участки между ними. Повторные запросы
+// используют уже найденные границы, поэтому суммарная работа не превышает полной сортировки.
+//
+// Уточнение краев lo и hi, попавших в разные участки, идет параллельно (второй край — задачей пула),
+// а неотсортированные участки внутри диапазона сортируются задачами пула одновременно.
+// Методы нельзя вызывать одновременно из нескольких потоков и из задач того же пула.
+
+template <typename RandomIt, typename Compare = std::less<>>
+class LazySortedView {
+public:
+    LazySortedView(RandomIt first, RandomIt last, ThreadPool &pool, Compare comp = {}, long threshold = 100000,
+                   const QuicksortOptions &opts = {})
+        : pool_(pool), first_(first), n_(long(last - first)), comp_(comp), threshold_(threshold), opts_(opts) {
+        segments_[0] = n_ < 2;
+        segments_[n_] = true; // Ограничитель
+    }
+
+    long size() const { return n_; }
+
+    // Элемент с номером rank в отсортированном порядке
+    typename std::iterator_traits<RandomIt>::reference at(long rank) {
+        if (rank < 0 || rank >= n_) throw std::out_of_range("ленивая сортировка: номер вне массива");
+        split_at(rank);
+        split_at(rank + 1);
+        return first_[rank];
+    }
+
+    // Отсортировать позиции [lo, hi) и вернуть их как диапазон
+    std::ranges::subrange<RandomIt> range(long lo, long hi) {
+        lo = std::clamp(lo, 0L, n_);
+        hi = std::clamp(hi, lo, n_);
+        if (lo == hi) return {first_ + lo, first_ + hi};
+        split_edges(lo, hi);
+        sort_inside(lo, hi);
+        return {first_ + lo, first_ + hi};
+    }
+
+    // Отсортирован ли весь массив
+    bool sorted() const { return n_ < 2 || (segments_.size() == 2 && segments_.begin()->second); }
+
+    // Число известных участков (для отладки и статистики)
+    long segments() const { return long(segments_.size()) - 1; }
+
+private:
+    // Участок [begin, end) и признак того, что он отсортирован
+    struct Piece {
+        long begin;
+        long end;
+        bool sorted;
+    };
+
+    using SegmentMap = std::map<long, bool>;
+
+    // Участок, содержащий позицию pos
+    SegmentMap::iterator segment_of(long pos) { return std::prev(segments_.upper_bound(pos)); }
+
+    // Нужно ли уточнять участок it, чтобы pos стала границей
+    bool needs_split(SegmentMap::iterator it, long pos) const { return it->first != pos && !it->second; }
+
+    // Разбивать [begin, end), пока pos не станет границей или не попадет в отсортированный участок.
+    // Карту участков не трогает, поэтому два разных участка можно уточнять одновременно
+    std::vector<Piece> refine(long begin, long end, long pos) const {
+        std::vector<Piece> pieces;
+        while (true) {
+            if (end - begin <= opts_.leaf_size) {
+                leaf_sort(first_ + begin, end - begin, opts_.leaf, comp_);
+                pieces.push_back({begin, end, true});
+                return pieces;
+            }
+            auto [r, l] = partition_step(first_, begin, end - 1, opts_, threshold_, comp_);
+            long mid_begin = std::clamp(r + 1, begin, end);
+            long mid_end = std::clamp(l, mid_begin, end);
+            Piece parts[3] = {{begin, mid_begin, false}, {mid_begin, mid_end, true}, {mid_end, end, false}};
+            const Piece* next = nullptr;
+            for (const Piece &p : parts) {
+                if (p.begin == p.end) continue;
+                if (!p.sorted && p.begin < pos && pos < p.end) next = &p; // Продолжаем только этот участок
+                else pieces.push_back(p);
+            }
+            if (!next) return pieces;
+            begin = next->begin;
+            end = next->end;
+        }
+    }
+
+    void apply(const std::vector<Piece> &pieces) {
+        for (const Piece &p : pieces) segments_[p.begin] = p.sorted;
+    }
+
+    void split_at(long pos) {
+        if (pos <= 0 || pos >= n_) return;
+        auto it = segment_of(pos);
+        if (needs_split(it, pos)) apply(refine(it->first, std::next(it)->first, pos));
+    }
+
+    // Сделать границами lo и hi; края в разных участках уточняются параллельно
+    void split_edges(long lo, long hi) {
+        auto a = segment_of(lo);
+        auto b = segment_of(hi < n_ ? hi : lo);
+        bool split_lo = lo > 0 && needs_split(a, lo);
+        bool split_hi = hi < n_ && needs_split(b, hi);
+        if (!split_lo || !split_hi || a == b) {
+            split_at(lo);
+            split_at(hi);
+            return;
+        }
+        std::vector<Piece> hi_pieces;
+        auto state = std::make_shared<QuicksortState>();
+        long b_begin = b->first, b_end = std::next(b)->first;
+        spawn_task_in_pool(pool_, state, [&, b_begin, b_end]() { hi_pieces = refine(b_begin, b_end, hi); });
+        auto done = state->prom->get_future();
+        std::vector<Piece> lo_pieces;
+        try {
+            lo_pieces = refine(a->first, std::next(a)->first, lo);
+        } catch (...) {
+            done.wait(); // hi_pieces и участок массива должны пережить задачу
+            throw;
+        }
+        done.get();
+        apply(lo_pieces);
+        apply(hi_pieces);
+    }
+
+    // Отсортировать неотсортированные участки внутри [lo, hi) (lo и hi — границы) и склеить их в один
+    void sort_inside(long lo, long hi) {
+        auto begin = segment_of(lo);
+        auto end = segments_.lower_bound(hi);
+        std::vector<std::pair<long, long>> jobs;
+        for (auto it = begin; it != end; ++it) {
+            if (!it->second) jobs.emplace_back(it->first, std::next(it)->first - 1);
+        }
+        if (!jobs.empty()) {
+            // Корневая задача держит счетчик, пока запускает остальные участки
+            auto state = std::make_shared<QuicksortState>();
+            state->opts = opts_;
+            spawn_task_in_pool(pool_, state, [this, &jobs, state]() {
+                for (size_t i = 1; i < jobs.size(); ++i) {
+                    auto [left, right] = jobs[i];
+                    spawn_task_in_pool(pool_, state, [this, left, right, state]() {
+                        quicksort_job(pool_, first_, left, right, state, threshold_, comp_);
+                    });
+                }
+                quicksort_job(pool_, first_, jobs[0].first, jobs[0].second, state, threshold_, comp_);
+            });
+            state->prom->get_future().get();
+        }
+        begin->second = true;
+        segments_.erase(std::next(begin), end);
+        // Склейка с отсортированными соседями
+        if (end != segments_.end() && end->first < n_ && end->second) segments_.erase(end);
+        if (begin != segments_.begin() && std::prev(begin)->second) segments_.erase(begin);
+    }
+
+    ThreadPool &pool_;
+    RandomIt first_;
+    long n_;
+    Compare comp_;
+    long threshold_;
+    QuicksortOptions opts_;
+    SegmentMap segments_; // Начало участка -> отсортирован ли он; последний ключ — n_
+};
@@ -0,0 +1,234 @@
+#pragma once
+#include <algorithm>
+#include <bit>
+#include <climits>
+#include <functional>
+#include <type_traits>
+#include <vector>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define LEAF_SORT_X86 1
+#include <immintrin.h>
+#endif
+
+
+
+// Алгоритм сортировки маленьких участков (листьев рекурсии)
+enum class LeafAlgorithm {
+    Std,    // std::sort
+    Network // Сортирующие сети в регистрах AVX2 + векторное слияние (для int, unsigned и float; иначе std::sort)
+};
+
+// Сортировка листа сетями: участок дополняется до кратного 64 значениями INT_MAX,
+// каждый блок из 64 ключей (8 регистров по 8) сортируется целиком в регистрах:
+// сеть по столбцам, транспонирование и битонные слияния 8 -> 16 -> 32 -> 64.
+// Затем блоки сливаются попарно векторным битонным слиянием по 8 ключей за шаг.
+// unsigned и float при копировании в буфер переводятся в int с тем же порядком и сортируются
+// теми же сетями (у float -0.0 оказывается перед +0.0, NaN — по своему битовому представлению).
+
+namespace leaf_sort_detail {
+
+#ifdef LEAF_SORT_X86
+
+#define LEAF_AVX2 __attribute__((target("avx2")))
+
+LEAF_AVX2 inline __m256i reverse8(__m256i v) {
+    return _mm256_permutevar8x32_epi32(v, _mm256_setr_epi32(7, 6, 5, 4, 3, 2, 1, 0));
+}
+
+LEAF_AVX2 inline void minmax(__m256i &a, __m256i &b) {
+    __m256i mn = _mm256_min_epi32(a, b);
+    b = _mm256_max_epi32(a, b);
+    a = mn;
+}
+
+// Упорядочить битонную последовательность из 8 элементов внутри регистра
+LEAF_AVX2 inline __m256i bitonic_clean8(__m256i v) {
+    __m256i p = _mm256_permute2x128_si256(v, v, 0x01);
+    v = _mm256_blend_epi32(_mm256_min_epi32(v, p), _mm256_max_epi32(v, p), 0xF0);
+    p = _mm256_shuffle_epi32(v, _MM_SHUFFLE(1, 0, 3, 2));
+    v = _mm256_blend_epi32(_mm256_min_epi32(v, p), _mm256_max_epi32(v, p), 0xCC);
+    p = _mm256_shuffle_epi32(v, _MM_SHUFFLE(2, 3, 0, 1));
+    v = _mm256_blend_epi32(_mm256_min_epi32(v, p), _mm256_max_epi32(v, p), 0xAA);
+    return v;
+}
+
+// Упорядочить битонную последовательность из K регистров
+template <int K>
+LEAF_AVX2 inline void bitonic_clean(__m256i* v) {
+    for (int d = K / 2; d >= 1; d /= 2) {
+        for (int i = 0; i < K; ++i) {
+            if ((i & d) == 0) minmax(v[i], v[i + d]);
+        }
+    }
+    for (int i = 0; i < K; ++i) v[i] = bitonic_clean8(v[i]);
+}
+
+// Слить два отсортированных отрезка по K регистров: v[0..K) и v[K..2K)
+template <int K>
+LEAF_AVX2 inline void bitonic_merge(__m256i* v) {
+    __m256i rev[K];
+    for (int i = 0; i < K; ++i) rev[i] = reverse8(v[2 * K - 1 - i]);
+    for (int i = 0; i < K; ++i) {
+        v[K + i] = _mm256_max_epi32(v[i], rev[i]);
+        v[i] = _mm256_min_epi32(v[i], rev[i]);
+    }
+    bitonic_clean<K>(v);
+    bitonic_clean<K>(v + K);
+}
+
+// Транспонирование матрицы 8x8 из регистров
+LEAF_AVX2 inline void transpose8(__m256i* r) {
+    __m256 t[8], u[8];
+    for (int i = 0; i < 8; i += 2) {
+        t[i] = _mm256_unpacklo_ps(_mm256_castsi256_ps(r[i]), _mm256_castsi256_ps(r[i + 1]));
+        t[i + 1] = _mm256_unpackhi_ps(_mm256_castsi256_ps(r[i]), _mm256_castsi256_ps(r[i + 1]));
+    }
+    for (int i = 0; i < 8; i += 4) {
+        u[i] = _mm256_shuffle_ps(t[i], t[i + 2], _MM_SHUFFLE(1, 0, 1, 0));
+        u[i + 1] = _mm256_shuffle_ps(t[i], t[i + 2], _MM_SHUFFLE(3, 2, 3, 2));
+        u[i + 2] = _mm256_shuffle_ps(t[i + 1], t[i + 3], _MM_SHUFFLE(1, 0, 1, 0));
+        u[i + 3] = _mm256_shuffle_ps(t[i + 1], t[i + 3], _MM_SHUFFLE(3, 2, 3, 2));
+    }
+    for (int i = 0; i < 4; ++i) {
+        r[i] = _mm256_castps_si256(_mm256_permute2f128_ps(u[i], u[i + 4], 0x20));
+        r[i + 4] = _mm256_castps_si256(_mm256_permute2f128_ps(u[i], u[i + 4], 0x31));
+    }
+}
+
+// Отсортировать блок из 64 элементов в регистрах
+LEAF_AVX2 inline void sort_block64(int* p) {
+    __m256i v[8];
+    for (int i = 0; i < 8; ++i) v[i] = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + 8 * i));
+    // Оптимальная сеть на 8 входов (19 компараторов) по столбцам
+    minmax(v[0], v[2]); minmax(v[1], v[3]); minmax(v[4], v[6]); minmax(v[5], v[7]);
+    minmax(v[0], v[4]); minmax(v[1], v[5]); minmax(v[2], v[6]); minmax(v[3], v[7]);
+    minmax(v[0], v[1]); minmax(v[2], v[3]); minmax(v[4], v[5]); minmax(v[6], v[7]);
+    minmax(v[2], v[4]); minmax(v[3], v[5]);
+    minmax(v[1], v[4]); minmax(v[3], v[6]);
+    minmax(v[1], v[2]); minmax(v[3], v[4]); minmax(v[5], v[6]);
+    transpose8(v); // Теперь каждый регистр — отсортированный отрезок из 8
+    for (int i = 0; i < 8; i += 2) bitonic_merge<1>(v + i);
+    for (int i = 0; i < 8; i += 4) bitonic_merge<2>(v + i);
+    bitonic_merge<4>(v);
+    for (int i = 0; i < 8; ++i) _mm256_storeu_si256(reinterpret_cast<__m256i*>(p + 8 * i), v[i]);
+}
+
+// Векторное слияние отсортированных a[0..na) и b[0..nb) в out (длины кратны 8)
+LEAF_AVX2 inline void merge_runs(const int* a, long na, const int* b, long nb, int* out) {
+    if (nb == 0) { std::copy(a, a + na, out); return; }
+    __m256i v[2];
+    v[0] = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a));
+    v[1] = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b));
+    long ia = 8, ib = 8;
+    while (true) {
+        bitonic_merge<1>(v);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out), v[0]);
+        out += 8;
+        v[0] = v[1];
+        if (ia < na && (ib >= nb || a[ia] <= b[ib])) {
+            v[1] = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + ia));
+            ia += 8;
+        } else if (ib < nb) {
+            v[1] = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + ib));
+            ib += 8;
+        } else {
+            break;
+        }
+    }
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out), v[0]);
+}
+
+#undef LEAF_AVX2
+
+// 32-битные типы, которые сортируются сетями
+template <typename T>
+inline constexpr bool network_type_v = std::is_same_v<T, int> || std::is_same_v<T, unsigned> || std::is_same_v<T, float>;
+
+// Ключ int с тем же порядком, что у значения; преобразование обратно само себе
+template <typename T>
+inline int network_key(T x) {
+    if constexpr (std::is_same_v<T, int>) {
+        return x;
+    } else if constexpr (std::is_same_v<T, unsigned>) {
+        return int(x ^ 0x80000000u);
+    } else {
+        int b = std::bit_cast<int>(x);
+        return b ^ int(unsigned(b >> 31) >> 1); // У отрицательных инвертируются все биты, кроме знакового
+    }
+}
+
+template <typename T>
+inline T network_value(int k) {
+    if constexpr (std::is_same_v<T, int>) {
+        return k;
+    } else if constexpr (std::is_same_v<T, unsigned>) {
+        return unsigned(k) ^ 0x80000000u;
+    } else {
+        return std::bit_cast<float>(k ^ int(unsigned(k >> 31) >> 1));
+    }
+}
+
+constexpr long stack_keys = 1024; // Листья до этого размера (с дополнением) сортируются в буферах на стеке
+
+// Сортировка участка 32-битных ключей сетями AVX2. Временные буферы листьев обычного размера
+// лежат на стеке, больших — в буферах текущего потока: первый лист на новом потоке не выделяет память
+template <typename T>
+__attribute__((target("avx2")))
+inline void network_sort(T* first, long n) {
+    alignas(32) int stack_a[stack_keys], stack_b[stack_keys];
+    long padded = (n + 63) / 64 * 64;
+    int* src = stack_a;
+    int* dst = stack_b;
+    if (padded > stack_keys) {
+        thread_local std::vector<int> buf_a, buf_b; // Создаются при первом большом листе потока
+        if (long(buf_a.size()) < padded) { buf_a.resize(padded); buf_b.resize(padded); }
+        src = buf_a.data();
+        dst = buf_b.data();
+    }
+    std::transform(first, first + n, src, network_key<T>);
+    std::fill(src + n, src + padded, INT_MAX);
+    for (long i = 0; i < padded; i += 64) sort_block64(src + i);
+    for (long width = 64; width < padded; width *= 2) {
+        for (long i = 0; i < padded; i += 2 * width) {
+            long mid = std::min(i + width, padded);
+            long end = std::min(i + 2 * width, padded);
+            merge_runs(src + i, mid - i, src + mid, end - mid, dst + i);
+        }
+        std::swap(src, dst);
+    }
+    std::transform(src, src + n, first, network_value<T>);
+}
+
+inline bool has_avx2() {
+    static const bool supported = [] {
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2") != 0;
+    }();
+    return supported;
+}
+
+#endif
+
+} // namespace leaf_sort_detail
+
+// Отсортировать лист [first, first + n) выбранным алгоритмом.
+// Сети применяются только к массивам int, unsigned и float с обычным порядком "<";
+// иначе — std::sort с компаратором
+template <typename RandomIt, typename Compare = std::less<>>
+void leaf_sort(RandomIt first, long n, LeafAlgorithm algorithm, Compare comp = {}) {
+#ifdef LEAF_SORT_X86
+    if constexpr (std::is_pointer_v<RandomIt>) {
+        using T = std::remove_pointer_t<RandomIt>;
+        if constexpr (leaf_sort_detail::network_type_v<T> &&
+                      (std::is_same_v<Compare, std::less<>> || std::is_same_v<Compare, std::less<T>>)) {
+            if (algorithm == LeafAlgorithm::Network && n >= 16 && leaf_sort_detail::has_avx2()) {
+                leaf_sort_detail::network_sort(first, n);
+                return;
+            }
+        }
+    }
+#endif
+    (void)algorithm;
+    std::sort(first, first + n, comp);
+}
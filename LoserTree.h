@@ -0,0 +1,44 @@
+#pragma once
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+
+
+// Дерево проигравших для k-путевого слияния: выбор следующего элемента за log k сравнений.
+// В узлах хранятся проигравшие, в tree_[0] — победитель.
+// beats(a, b) — источник a должен выдать элемент раньше b
+template <typename Beats>
+class LoserTree {
+public:
+    LoserTree(long k, Beats beats) : k_(k), tree_(std::max(k, 1L)), beats_(beats) {
+        tree_[0] = k_ > 1 ? build(1) : 0;
+    }
+
+    long winner() const { return tree_[0]; }
+
+    // Источник-победитель сменил текущий элемент: переиграть путь от его листа до корня
+    void replay() {
+        long w = tree_[0];
+        for (long node = (w + k_) / 2; node > 0; node /= 2) {
+            if (beats_(tree_[node], w)) std::swap(tree_[node], w);
+        }
+        tree_[0] = w;
+    }
+
+private:
+    long build(long node) {
+        if (node >= k_) return node - k_;
+        long a = build(2 * node), b = build(2 * node + 1);
+        if (beats_(a, b)) {
+            tree_[node] = b;
+            return a;
+        }
+        tree_[node] = a;
+        return b;
+    }
+
+    long k_;
+    std::vector<long> tree_;
+    Beats beats_;
+};
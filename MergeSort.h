@@ -0,0 +1,227 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <optional>
+#include <vector>
+#include "Quicksort.h"
+
+
+
+// Устойчивая параллельная сортировка слиянием: равные ключи сохраняют исходный порядок.
+//
+// Половины сортируются задачами пула; последняя завершившаяся половина запускает слияние родителя
+// (без ожидания в потоках). Само слияние тоже делится между задачами: выход разбивается на равные
+// части, и для начала каждой части бинарным поиском по "пути слияния" (co-ranking) находятся
+// позиции в обоих входах. Листья сортируются последовательно: вставками короткие серии,
+// затем слияниями через буфер. Уровни чередуют массив и буфер, чтобы не копировать данные обратно.
+
+namespace merge_detail {
+
+constexpr long insertion_run = 32;   // Длина серий, сортируемых вставками
+constexpr long min_piece = 1L << 16; // Минимальная часть параллельного слияния
+
+template <typename T, typename Compare> struct MergeNode;
+
+// Общие данные сортировки
+template <typename T, typename Compare>
+struct MergeContext {
+    ThreadPool &pool;
+    std::shared_ptr<QuicksortState> state;
+    T* a;
+    T* buf;
+    std::vector<T> owned_scratch;
+    Compare comp;
+    long threshold;
+    MergeNode<T, Compare>* nodes = nullptr; // Готовая память узлов (если nullptr — узлы создаются в куче)
+    std::atomic<long> next_node {0};        // Следующий свободный узел в nodes
+
+    MergeContext(ThreadPool &p, std::shared_ptr<QuicksortState> s, T* array, Compare c, long thr)
+        : pool(p), state(std::move(s)), a(array), buf(nullptr), comp(c), threshold(thr) {}
+};
+
+// Узел дерева рекурсии: участок [b, e), результат которого должен оказаться в буфере или в массиве
+template <typename T, typename Compare>
+struct MergeNode {
+    std::shared_ptr<MergeContext<T, Compare>> ctx;
+    std::shared_ptr<MergeNode> parent;
+    long b = 0, e = 0;
+    bool to_buf = false;
+    std::atomic<long> pending {2}; // Сначала — незавершенные дети, затем — части слияния
+
+    MergeNode() = default;
+    MergeNode(std::shared_ptr<MergeContext<T, Compare>> c, std::shared_ptr<MergeNode> p, long begin, long end, bool tb)
+        : ctx(std::move(c)), parent(std::move(p)), b(begin), e(end), to_buf(tb) {}
+};
+
+// Число узлов дерева рекурсии для участка из n элементов
+inline long count_nodes(long n, long threshold) {
+    if (n <= threshold) return 1;
+    return 1 + count_nodes(n / 2, threshold) + count_nodes(n - n / 2, threshold);
+}
+
+// Создать узел: в готовой памяти контекста, если она есть (указатель разделяет владельца контекста
+// и не выделяет память), иначе — в куче
+template <typename T, typename Compare>
+std::shared_ptr<MergeNode<T, Compare>> make_node(const std::shared_ptr<MergeContext<T, Compare>> &ctx,
+                                                 std::shared_ptr<MergeNode<T, Compare>> parent, long b, long e, bool to_buf) {
+    if (!ctx->nodes) return std::make_shared<MergeNode<T, Compare>>(ctx, std::move(parent), b, e, to_buf);
+    auto &node = ctx->nodes[ctx->next_node.fetch_add(1, std::memory_order_relaxed)];
+    node.ctx = ctx;
+    node.parent = std::move(parent);
+    node.b = b;
+    node.e = e;
+    node.to_buf = to_buf;
+    node.pending.store(2, std::memory_order_relaxed);
+    return std::shared_ptr<MergeNode<T, Compare>>(ctx, &node);
+}
+
+// Позиция i в A такая, что первые d элементов слияния — это A[0..i) и B[0..d-i).
+// При равенстве первыми идут элементы A, что и дает устойчивость
+template <typename T, typename Compare>
+long co_rank(long d, const T* A, long na, const T* B, long nb, Compare &comp) {
+    long lo = std::max(0L, d - nb), hi = std::min(d, na);
+    while (lo < hi) {
+        long i = lo + (hi - lo) / 2;
+        long j = d - i;
+        if (j > 0 && i < na && !comp(B[j - 1], A[i])) lo = i + 1;
+        else hi = i;
+    }
+    return lo;
+}
+
+// Последовательная устойчивая сортировка [b, e): результат в dst_is_buf ? buf : a
+template <typename T, typename Compare>
+void stable_small_sort(T* a, T* buf, long b, long e, bool dst_is_buf, Compare &comp) {
+    for (long run = b; run < e; run += insertion_run) {
+        long run_end = std::min(run + insertion_run, e);
+        for (long i = run + 1; i < run_end; ++i) {
+            T x = std::move(a[i]);
+            long j = i;
+            for (; j > run && comp(x, a[j - 1]); --j) a[j] = std::move(a[j - 1]);
+            a[j] = std::move(x);
+        }
+    }
+    T* src = a;
+    T* dst = buf;
+    for (long width = insertion_run; width < e - b; width *= 2) {
+        for (long lo = b; lo < e; lo += 2 * width) {
+            long mid = std::min(lo + width, e), hi = std::min(lo + 2 * width, e);
+            std::merge(std::make_move_iterator(src + lo), std::make_move_iterator(src + mid),
+                       std::make_move_iterator(src + mid), std::make_move_iterator(src + hi), dst + lo, comp);
+        }
+        std::swap(src, dst);
+    }
+    T* want = dst_is_buf ? buf : a;
+    if (src != want) std::move(src + b, src + e, want + b);
+}
+
+template <typename T, typename Compare> void sort_node(std::shared_ptr<MergeNode<T, Compare>> node);
+
+// Узел готов: сообщаем родителю; второй завершившийся ребенок запускает слияние
+template <typename T, typename Compare>
+void finish_node(std::shared_ptr<MergeNode<T, Compare>> node);
+
+// Слить отсортированные половины узла частями, каждая часть — отдельная задача пула
+template <typename T, typename Compare>
+void merge_node(std::shared_ptr<MergeNode<T, Compare>> node) {
+    auto &ctx = *node->ctx;
+    T* src = node->to_buf ? ctx.a : ctx.buf;
+    T* dst = node->to_buf ? ctx.buf : ctx.a;
+    long mid = node->b + (node->e - node->b) / 2;
+    long n = node->e - node->b;
+    long pieces = std::clamp(n / min_piece, 1L, long(ctx.pool.size()));
+    node->pending.store(pieces);
+    auto merge_piece = [node, src, dst, mid, n, pieces](long k) {
+        auto &c = *node->ctx;
+        const T* A = src + node->b;
+        const T* B = src + mid;
+        long na = mid - node->b, nb = node->e - mid;
+        long d0 = k * n / pieces, d1 = (k + 1) * n / pieces;
+        long i0 = co_rank(d0, A, na, B, nb, c.comp), i1 = co_rank(d1, A, na, B, nb, c.comp);
+        std::merge(std::make_move_iterator(src + node->b + i0), std::make_move_iterator(src + node->b + i1),
+                   std::make_move_iterator(src + mid + (d0 - i0)), std::make_move_iterator(src + mid + (d1 - i1)),
+                   dst + node->b + d0, c.comp);
+        if (node->pending.fetch_sub(1, std::memory_order_acq_rel) == 1) finish_node(node);
+    };
+    for (long k = 1; k < pieces; ++k) {
+        spawn_task_in_pool(ctx.pool, ctx.state, [merge_piece, k]() { merge_piece(k); });
+    }
+    merge_piece(0);
+}
+
+template <typename T, typename Compare>
+void finish_node(std::shared_ptr<MergeNode<T, Compare>> node) {
+    auto parent = node->parent;
+    if (parent && parent->pending.fetch_sub(1, std::memory_order_acq_rel) == 1) merge_node(parent);
+}
+
+template <typename T, typename Compare>
+void sort_node(std::shared_ptr<MergeNode<T, Compare>> node) {
+    auto &ctx = *node->ctx;
+    long n = node->e - node->b;
+    if (n <= ctx.threshold) {
+        stable_small_sort(ctx.a, ctx.buf, node->b, node->e, node->to_buf, ctx.comp);
+        finish_node(node);
+        return;
+    }
+    long mid = node->b + n / 2;
+    auto left = make_node(node->ctx, node, node->b, mid, !node->to_buf);
+    auto right = make_node(node->ctx, node, mid, node->e, !node->to_buf);
+    spawn_task_in_pool(ctx.pool, ctx.state, [left]() { sort_node(left); });
+    sort_node(right);
+}
+
+} // namespace merge_detail
+
+// Переиспользуемая память сортировки слиянием: контекст и узлы дерева рекурсии.
+// Повторный запуск с тем же размером участка и порогом не выделяет память
+template <typename T, typename Compare = std::less<>>
+struct MergeWorkspace {
+    std::optional<merge_detail::MergeContext<T, Compare>> ctx;
+    std::unique_ptr<merge_detail::MergeNode<T, Compare>[]> nodes;
+    long node_capacity = 0;
+};
+
+// Асинхронная устойчивая сортировка слиянием участка [left, right] через пул потоков.
+// scratch — буфер того же размера, что и массив (индексируется так же); если nullptr, выделяется внутри.
+template <typename T, typename Compare = std::less<>>
+std::future<void> merge_sort_async(ThreadPool &pool, T* array, long left, long right, long threshold = 100000,
+                                   Compare comp = {}, T* scratch = nullptr) {
+    using namespace merge_detail;
+    auto state = std::make_shared<QuicksortState>();
+    long n = std::max(0L, right - left + 1);
+    auto ctx = std::make_shared<MergeContext<T, Compare>>(pool, state, array + left, comp, std::max(threshold, insertion_run));
+    if (scratch) {
+        ctx->buf = scratch + left;
+    } else {
+        ctx->owned_scratch.resize(n);
+        ctx->buf = ctx->owned_scratch.data();
+    }
+    auto root = std::make_shared<MergeNode<T, Compare>>(ctx, nullptr, 0, n, false);
+    spawn_task_in_pool(pool, state, [root]() { sort_node(root); });
+    return state->prom->get_future();
+}
+
+// Вариант с состоянием и памятью вызывающего: задачи запускаются на state (его готовят restart()
+// и дожидаются wait()), контекст и узлы берутся из ws. scratch — буфер того же размера, что и массив.
+template <typename T, typename Compare>
+void merge_sort_async(ThreadPool &pool, T* array, long left, long right, std::shared_ptr<QuicksortState> state,
+                      MergeWorkspace<T, Compare> &ws, T* scratch, long threshold = 100000, Compare comp = {}) {
+    using namespace merge_detail;
+    long n = std::max(0L, right - left + 1);
+    threshold = std::max(threshold, insertion_run);
+    long nodes = count_nodes(n, threshold);
+    if (ws.node_capacity < nodes) {
+        ws.nodes = std::make_unique<MergeNode<T, Compare>[]>(nodes);
+        ws.node_capacity = nodes;
+    }
+    ws.ctx.emplace(pool, state, array + left, comp, threshold);
+    ws.ctx->buf = scratch + left;
+    ws.ctx->nodes = ws.nodes.get();
+    std::shared_ptr<MergeContext<T, Compare>> ctx(state, &*ws.ctx);
+    auto root = make_node(ctx, std::shared_ptr<MergeNode<T, Compare>>(), 0, n, false);
+    spawn_task_in_pool(pool, state, [root]() { sort_node(root); });
+}
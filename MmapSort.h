@@ -0,0 +1,176 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <filesystem>
+#include <functional>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include "ThreadPool.h"
+#include "ParallelSort.h"
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+
+
+// Сортировка двоичного файла на месте через отображение в память.
+//
+// Файл отображается целиком на чтение и запись, ядру сообщается, что страницы скоро понадобятся
+// (и, где возможно, что желательны большие страницы), после чего параллельная сортировка работает
+// прямо на отображении: копий в буфер процесса и обратно нет. Измененные страницы сбрасываются
+// на диск параллельно, каждая задача пула — свой диапазон страниц. Подсказка о последовательном
+// доступе для всего файла не дается: разбиения обращаются к участкам с обоих концов, а
+// последовательный режим в Linux освобождает уже прочитанные страницы.
+
+// Файл, отображенный в память на чтение и запись
+class MappedFile {
+public:
+    explicit MappedFile(const std::filesystem::path &path) {
+#ifdef _WIN32
+        file_ = CreateFileW(path.wstring().c_str(), GENERIC_READ | GENERIC_WRITE, 0, nullptr, OPEN_EXISTING,
+                            FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file_ == INVALID_HANDLE_VALUE) throw std::runtime_error("отображение файла: не удалось открыть " + path.string());
+        LARGE_INTEGER size;
+        if (!GetFileSizeEx(file_, &size)) {
+            close();
+            throw std::runtime_error("отображение файла: не удалось получить размер " + path.string());
+        }
+        size_ = size_t(size.QuadPart);
+        if (size_ == 0) return;
+        mapping_ = CreateFileMappingW(file_, nullptr, PAGE_READWRITE, 0, 0, nullptr);
+        if (mapping_) data_ = MapViewOfFile(mapping_, FILE_MAP_ALL_ACCESS, 0, 0, 0);
+        if (!data_) {
+            close();
+            throw std::runtime_error("отображение файла: не удалось отобразить " + path.string());
+        }
+#else
+        fd_ = ::open(path.c_str(), O_RDWR);
+        if (fd_ < 0) throw std::runtime_error("отображение файла: не удалось открыть " + path.string());
+        struct stat st {};
+        if (::fstat(fd_, &st) != 0) {
+            close();
+            throw std::runtime_error("отображение файла: не удалось получить размер " + path.string());
+        }
+        size_ = size_t(st.st_size);
+        if (size_ == 0) return;
+        void* p = ::mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+        if (p == MAP_FAILED) {
+            close();
+            throw std::runtime_error("отображение файла: не удалось отобразить " + path.string());
+        }
+        data_ = p;
+#endif
+    }
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+    ~MappedFile() { close(); }
+
+    void* data() const { return data_; }
+    size_t size() const { return size_; }
+
+    // Гранулярность диапазонов для сброса на диск
+    static size_t page_size() {
+#ifdef _WIN32
+        SYSTEM_INFO info;
+        GetSystemInfo(&info);
+        return size_t(info.dwPageSize);
+#else
+        return size_t(::sysconf(_SC_PAGESIZE));
+#endif
+    }
+
+    // Подсказки ядру: страницы понадобятся скоро, большие страницы желательны (ошибки не критичны)
+    void advise_will_need() const {
+        if (!data_) return;
+#ifdef _WIN32
+#if defined(_WIN32_WINNT) && _WIN32_WINNT >= 0x0602
+        WIN32_MEMORY_RANGE_ENTRY range {data_, size_};
+        PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+#endif
+#else
+        ::madvise(data_, size_, MADV_WILLNEED);
+#ifdef MADV_HUGEPAGE
+        ::madvise(data_, size_, MADV_HUGEPAGE);
+#endif
+#endif
+    }
+
+    // Синхронно сбросить на диск диапазон [offset, offset + length) (offset кратен page_size())
+    void flush(size_t offset, size_t length) const {
+        if (!data_ || length == 0) return;
+        char* p = static_cast<char*>(data_) + offset;
+#ifdef _WIN32
+        if (!FlushViewOfFile(p, length)) throw std::runtime_error("отображение файла: ошибка сброса на диск");
+#else
+        if (::msync(p, length, MS_SYNC) != 0) throw std::runtime_error("отображение файла: ошибка сброса на диск");
+#endif
+    }
+
+    // Дождаться записи метаданных и буферов файла (после flush всех диапазонов)
+    void sync_file() const {
+#ifdef _WIN32
+        if (file_ != INVALID_HANDLE_VALUE && !FlushFileBuffers(file_)) {
+            throw std::runtime_error("отображение файла: ошибка сброса на диск");
+        }
+#endif
+    }
+
+private:
+    void close() {
+#ifdef _WIN32
+        if (data_) UnmapViewOfFile(data_);
+        if (mapping_) CloseHandle(mapping_);
+        if (file_ != INVALID_HANDLE_VALUE) CloseHandle(file_);
+        mapping_ = nullptr;
+        file_ = INVALID_HANDLE_VALUE;
+#else
+        if (data_) ::munmap(data_, size_);
+        if (fd_ >= 0) ::close(fd_);
+        fd_ = -1;
+#endif
+        data_ = nullptr;
+    }
+
+#ifdef _WIN32
+    HANDLE file_ = INVALID_HANDLE_VALUE;
+    HANDLE mapping_ = nullptr;
+#else
+    int fd_ = -1;
+#endif
+    void* data_ = nullptr;
+    size_t size_ = 0;
+};
+
+// Отсортировать на месте файл из элементов T, отображенный в память, и сбросить его на диск.
+// Нельзя вызывать из задачи того же пула. Ошибки — std::runtime_error
+template <typename T, typename Compare = std::less<>>
+void mmap_sort(const std::filesystem::path &path, ThreadPool &pool, Compare comp = {}) {
+    static_assert(std::is_trivially_copyable_v<T>, "сортировка отображения работает с элементами фиксированного размера");
+    MappedFile file(path);
+    if (file.size() % sizeof(T) != 0) throw std::runtime_error("отображение файла: размер не кратен размеру элемента");
+    if (file.size() == 0) return;
+    file.advise_will_need();
+
+    T* first = static_cast<T*>(file.data());
+    parallel_sort(first, first + file.size() / sizeof(T), comp, pool);
+
+    // Сброс измененных страниц частями, выровненными по странице
+    size_t page = MappedFile::page_size();
+    long pages = long((file.size() + page - 1) / page);
+    parallel_for(pool, pages, 256, [&](long b, long e) {
+        size_t offset = size_t(b) * page;
+        file.flush(offset, std::min(file.size(), size_t(e) * page) - offset);
+    });
+    file.sync_file();
+}
@@ -0,0 +1,114 @@
+#pragma once
+#include <algorithm>
+#include <exception>
+#include <functional>
+#include <future>
+#include <iterator>
+#include <memory>
+#include "ThreadPool.h"
+#include "Quicksort.h"
+#include "CountingSort.h"
+#include "Presorted.h"
+
+
+
+// Обобщенная параллельная сортировка [first, last) для любого итератора произвольного доступа.
+//
+// Компаратор передается параметром шаблона, поэтому во внутреннем цикле он встраивается без
+// косвенных вызовов. Непрерывные итераторы (указатели, std::vector, std::array) сводятся к указателю,
+// и тогда для арифметических типов с std::less выбираются блочное/векторное ядра и сети на листьях.
+// Тип элементов должен быть перемещаемым и копируемым (опорный элемент хранится копией).
+
+namespace parallel_sort_detail {
+
+// Настройки по умолчанию: самые быстрые ядра (для неподходящих типов они отключаются на этапе компиляции)
+inline QuicksortOptions default_options() {
+    QuicksortOptions opts;
+    opts.kernel = PartitionKernel::Simd;
+    return opts;
+}
+
+} // namespace parallel_sort_detail
+
+// Выполнить fn(begin, end) над частями [0, n) задачами пула и дождаться завершения.
+// Части не меньше grain элементов и их не больше, чем потоков; первая часть выполняется в текущем потоке.
+// Нельзя вызывать из задачи того же пула.
+template <typename Fn>
+void parallel_for(ThreadPool &pool, long n, long grain, Fn fn) {
+    if (n <= 0) return;
+    long chunks = std::clamp(n / std::max(grain, 1L), 1L, long(pool.size()));
+    if (chunks == 1) {
+        fn(0L, n);
+        return;
+    }
+    auto state = std::make_shared<QuicksortState>();
+    // Части 2.. запускает задача части 1: пока она держит счетчик, он не обнулится раньше времени
+    spawn_task_in_pool(pool, state, [=, &pool]() {
+        for (long c = 2; c < chunks; ++c) {
+            spawn_task_in_pool(pool, state, [=]() { fn(c * n / chunks, (c + 1) * n / chunks); });
+        }
+        fn(n / chunks, 2 * n / chunks);
+    });
+    auto fut = state->prom->get_future();
+    std::exception_ptr first_error;
+    try {
+        fn(0L, n / chunks);
+    } catch (...) {
+        first_error = std::current_exception();
+    }
+    fut.get();
+    if (first_error) std::rethrow_exception(first_error);
+}
+
+namespace parallel_sort_detail {
+
+// Сортировка участка [0, n) без учета упорядоченности: целые с обычным порядком — подсчетом
+// (если диапазон значений мал, иначе той же быстрой сортировкой), остальное — быстрой сортировкой
+template <typename RandomIt, typename Compare>
+void sort_job(ThreadPool &pool, RandomIt array, long n, std::shared_ptr<QuicksortState> state, long threshold,
+              Compare comp) {
+    using T = std::remove_pointer_t<RandomIt>;
+    if constexpr (uses_fast_kernels_v<RandomIt, Compare> && std::is_integral_v<T> && !std::is_same_v<T, bool>) {
+        counting_sort_job(pool, array, 0, n - 1, state, threshold);
+    } else {
+        quicksort_job(pool, array, 0, n - 1, state, threshold, comp);
+    }
+}
+
+} // namespace parallel_sort_detail
+
+// Асинхронная сортировка [first, last) через пул потоков.
+// Сначала распознается упорядоченность (отсортированные, убывающие и составленные из нескольких серий
+// данные обрабатываются без полной сортировки)
+template <typename RandomIt, typename Compare = std::less<>>
+std::future<void> parallel_sort_async(RandomIt first, RandomIt last, Compare comp, ThreadPool &pool,
+                                      long threshold = 100000) {
+    long n = long(last - first);
+    auto state = std::make_shared<QuicksortState>();
+    state->opts = parallel_sort_detail::default_options();
+    auto start = [=, &pool](auto array) {
+        spawn_task_in_pool(pool, state, [=, &pool]() {
+            presorted_job(pool, array, 0, n - 1, state, comp, [=, &pool]() {
+                parallel_sort_detail::sort_job(pool, array, n, state, threshold, comp);
+            });
+        });
+    };
+    if constexpr (std::contiguous_iterator<RandomIt>) {
+        start(std::to_address(first));
+    } else {
+        start(first);
+    }
+    return state->prom->get_future();
+}
+
+// Отсортировать [first, last) и дождаться завершения (исключения из задач пробрасываются).
+// Нельзя вызывать из задачи того же пула: поток будет заблокирован ожиданием.
+template <typename RandomIt, typename Compare>
+void parallel_sort(RandomIt first, RandomIt last, Compare comp, ThreadPool &pool) {
+    parallel_sort_async(first, last, comp, pool).get();
+}
+
+template <typename RandomIt>
+void parallel_sort(RandomIt first, RandomIt last, ThreadPool &pool) {
+    parallel_sort(first, last, std::less<>{}, pool);
+}
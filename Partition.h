@@ -0,0 +1,159 @@
+#pragma once
+#include <algorithm>
+#include <functional>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+
+
+
+// Режим разбиения участка массива
+enum class PartitionMode {
+    Hoare,    // Классическое разбиение Хоара на две части
+    ThreeWay, // Разбиение на три части (< pivot, == pivot, > pivot) — "голландский флаг"
+    Auto      // Трехчастное разбиение включается, если выборка показывает много повторов
+};
+
+// Ядро двухчастного разбиения
+enum class PartitionKernel {
+    Loop,  // Цикл Хоара с ветвлениями на каждом элементе
+    Block, // Блочное разбиение без ветвлений (BlockQuicksort), только для арифметических типов
+    Simd   // Векторное разбиение AVX2/AVX-512 с выбором по CPUID (SimdPartition.h), только для int
+};
+
+// Можно ли использовать специализированные ядра (блочное, векторное): указатель на арифметический тип
+// и обычный порядок "<"
+template <typename RandomIt, typename Compare>
+inline constexpr bool uses_fast_kernels_v = [] {
+    if constexpr (std::is_pointer_v<RandomIt>) {
+        using T = std::remove_cv_t<std::remove_pointer_t<RandomIt>>;
+        return std::is_arithmetic_v<T> && (std::is_same_v<Compare, std::less<>> || std::is_same_v<Compare, std::less<T>>);
+    } else {
+        return false;
+    }
+}();
+
+// Результат разбиения: после него нужно отсортировать [left, r] и [l, right],
+// элементы между r и l уже стоят на своих местах
+struct PartitionResult {
+    long r;
+    long l;
+};
+
+// Разбиение Хоара участка [left, right] относительно значения pivot (pivot должен присутствовать в участке)
+template <typename RandomIt, typename T, typename Compare = std::less<>>
+PartitionResult partition_hoare(RandomIt array, long left, long right, const T &pivot, Compare comp = {}) {
+    using std::swap;
+    long l = left, r = right;
+    do {
+        while (comp(array[l], pivot)) ++l;
+        while (comp(pivot, array[r])) --r;
+        if (l <= r) {
+            swap(array[l], array[r]);
+            ++l; --r;
+        }
+    } while (l <= r);
+    return {r, l};
+}
+
+// Блочное разбиение (BlockQuicksort, Edelkamp & Weiß): смещения неправильно расположенных элементов
+// сначала записываются в буферы без ветвлений, затем элементы меняются местами пачкой.
+// Элементы, равные pivot, как и в цикле Хоара, могут оказаться в любой из частей.
+template <typename T>
+PartitionResult partition_block(T* array, long left, long right, const T pivot) {
+    static_assert(std::is_arithmetic_v<T>, "partition_block поддерживает только арифметические типы");
+    constexpr long block = 128;
+    unsigned char offsets_l[block];
+    unsigned char offsets_r[block];
+    long l = left, r = right; // Необработанная часть — [l, r]
+    long num_l = 0, num_r = 0, start_l = 0, start_r = 0;
+
+    while (r - l + 1 > 2 * block) {
+        // Заполняем буфер левого блока: позиции элементов >= pivot
+        if (num_l == 0) {
+            start_l = 0;
+            for (long i = 0; i < block; ++i) {
+                offsets_l[num_l] = static_cast<unsigned char>(i);
+                num_l += !(array[l + i] < pivot);
+            }
+        }
+        // Заполняем буфер правого блока: позиции элементов <= pivot
+        if (num_r == 0) {
+            start_r = 0;
+            for (long i = 0; i < block; ++i) {
+                offsets_r[num_r] = static_cast<unsigned char>(i);
+                num_r += !(pivot < array[r - i]);
+            }
+        }
+        // Меняем местами найденные пары
+        long num = std::min(num_l, num_r);
+        for (long k = 0; k < num; ++k) {
+            std::swap(array[l + offsets_l[start_l + k]], array[r - offsets_r[start_r + k]]);
+        }
+        num_l -= num; num_r -= num;
+        start_l += num; start_r += num;
+        if (num_l == 0) l += block;
+        if (num_r == 0) r -= block;
+    }
+
+    // Остаток (не больше трех блоков) разбиваем обычным циклом с проверкой границ
+    long i = l, j = r;
+    while (true) {
+        while (i <= j && array[i] < pivot) ++i;
+        while (i <= j && pivot < array[j]) --j;
+        if (i >= j) break;
+        std::swap(array[i], array[j]);
+        ++i; --j;
+    }
+
+    // [left, i) <= pivot, [i, right] >= pivot. Если одна из частей пуста, отделяем один элемент,
+    // равный pivot, чтобы рекурсия гарантированно продвигалась
+    if (i == left) {
+        long k = left;
+        while (array[k] < pivot || pivot < array[k]) ++k;
+        std::swap(array[left], array[k]);
+        return {left - 1, left + 1};
+    }
+    if (i == right + 1) {
+        long k = right;
+        while (array[k] < pivot || pivot < array[k]) --k;
+        std::swap(array[right], array[k]);
+        return {right - 1, right + 1};
+    }
+    return {i - 1, i};
+}
+
+// Трехчастное разбиение Дейкстры за один проход: элементы, равные pivot, собираются в середине
+// и больше не участвуют в рекурсии
+template <typename RandomIt, typename T, typename Compare = std::less<>>
+PartitionResult partition_three_way(RandomIt array, long left, long right, const T &pivot, Compare comp = {}) {
+    using std::swap;
+    long lt = left, i = left, gt = right;
+    while (i <= gt) {
+        if (comp(array[i], pivot)) {
+            swap(array[lt++], array[i++]);
+        } else if (comp(pivot, array[i])) {
+            swap(array[i], array[gt--]);
+        } else {
+            ++i;
+        }
+    }
+    return {lt - 1, gt + 1};
+}
+
+// Оценить по равномерной выборке, много ли на участке повторяющихся ключей
+template <typename RandomIt, typename Compare = std::less<>>
+bool has_many_duplicates(RandomIt array, long left, long right, Compare comp = {}) {
+    constexpr long samples = 32;
+    long n = right - left + 1;
+    if (n < samples * 4) return false;
+    long index[samples];
+    long step = n / samples;
+    for (long i = 0; i < samples; ++i) index[i] = left + i * step;
+    std::sort(index, index + samples, [&](long a, long b) { return comp(array[a], array[b]); });
+    long dups = 0;
+    for (long i = 1; i < samples; ++i) {
+        if (!comp(array[index[i - 1]], array[index[i]])) ++dups;
+    }
+    return dups * 4 >= samples; // Не меньше четверти выборки — повторы
+}
@@ -0,0 +1,107 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <vector>
+
+
+
+// Стратегия выбора опорного элемента для разбиения
+enum class PivotStrategy {
+    Middle,  // Один элемент из середины участка (исходное поведение)
+    Median3, // Медиана из первого, среднего и последнего элементов
+    Ninther, // Медиана трех медиан из трех (ninther Тьюки)
+    Sampled  // Медиана случайной выборки размера sqrt(n) на верхних уровнях, ниже — ninther
+};
+
+// Статистика сбалансированности разбиений (для отладки)
+struct PartitionStats {
+    std::atomic<long> partitions {0};     // Количество выполненных разбиений
+    std::atomic<long> skewed {0};         // Разбиения, где меньшая часть < 10% участка
+    std::atomic<long> balance_sum {0};    // Сумма долей меньшей части (в тысячных)
+    std::atomic<long> worst_balance {500}; // Худшая доля меньшей части (в тысячных)
+
+    // Учесть одно разбиение участка размера total, меньшая часть которого имеет размер smaller
+    void record(long total, long smaller) {
+        if (total <= 0) return;
+        long balance = smaller * 1000 / total;
+        partitions.fetch_add(1, std::memory_order_relaxed);
+        balance_sum.fetch_add(balance, std::memory_order_relaxed);
+        if (balance < 100) skewed.fetch_add(1, std::memory_order_relaxed);
+        long worst = worst_balance.load(std::memory_order_relaxed);
+        while (balance < worst && !worst_balance.compare_exchange_weak(worst, balance, std::memory_order_relaxed)) {}
+    }
+
+    // Средняя доля меньшей части разбиения (0.5 — идеальный баланс)
+    double average_balance() const {
+        long n = partitions.load();
+        return n ? double(balance_sum.load()) / 1000.0 / double(n) : 0.5;
+    }
+};
+
+namespace pivot_detail {
+
+// Индекс медианы из трех элементов массива
+template <typename RandomIt, typename Compare>
+inline long median3_index(RandomIt array, long a, long b, long c, Compare &comp) {
+    if (comp(array[a], array[b])) {
+        if (comp(array[b], array[c])) return b;
+        return comp(array[a], array[c]) ? c : a;
+    }
+    if (comp(array[a], array[c])) return a;
+    return comp(array[b], array[c]) ? c : b;
+}
+
+// Простой генератор xorshift для выборки (детерминированный, без общего состояния)
+inline uint64_t xorshift64(uint64_t &s) {
+    s ^= s << 13;
+    s ^= s >> 7;
+    s ^= s << 17;
+    return s;
+}
+
+} // namespace pivot_detail
+
+// Выбрать значение опорного элемента на участке [left, right].
+// Возвращаемое значение всегда присутствует в участке, что важно для цикла разбиения Хоара.
+// sample_cutoff — размер участка, начиная с которого стратегия Sampled использует выборку sqrt(n).
+template <typename RandomIt, typename Compare = std::less<>>
+typename std::iterator_traits<RandomIt>::value_type
+select_pivot(RandomIt array, long left, long right, PivotStrategy strategy, long sample_cutoff, Compare comp = {}) {
+    using T = typename std::iterator_traits<RandomIt>::value_type;
+    using namespace pivot_detail;
+    long n = right - left + 1;
+    long mid = left + (right - left) / 2;
+    switch (strategy) {
+    case PivotStrategy::Middle:
+        return array[mid];
+    case PivotStrategy::Median3:
+        return array[median3_index(array, left, mid, right, comp)];
+    case PivotStrategy::Sampled:
+        if (n > sample_cutoff) {
+            long k = std::max(3L, long(std::sqrt(double(n))));
+            std::vector<T> sample;
+            sample.reserve(k);
+            uint64_t seed = uint64_t(left) * 0x9E3779B97F4A7C15ull + uint64_t(right) + 1;
+            for (long i = 0; i < k; ++i) {
+                sample.push_back(array[left + long(xorshift64(seed) % uint64_t(n))]);
+            }
+            std::nth_element(sample.begin(), sample.begin() + k / 2, sample.end(), comp);
+            return sample[k / 2];
+        }
+        [[fallthrough]];
+    case PivotStrategy::Ninther:
+        if (n < 64) return array[median3_index(array, left, mid, right, comp)];
+        {
+            long step = n / 8;
+            long a = median3_index(array, left, left + step, left + 2 * step, comp);
+            long b = median3_index(array, mid - step, mid, mid + step, comp);
+            long c = median3_index(array, right - 2 * step, right - step, right, comp);
+            return array[median3_index(array, a, b, c, comp)];
+        }
+    }
+    return array[mid];
+}
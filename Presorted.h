@@ -0,0 +1,238 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <utility>
+#include <vector>
+#include "Quicksort.h"
+#include "LoserTree.h"
+
+
+
+// Распознавание предварительной упорядоченности перед сортировкой.
+//
+// Первая волна задач пула ищет в своих частях массива места спуска (a[i] < a[i-1]) и подъема,
+// запоминая не больше max_runs позиций спуска. Часть, в которой встретились и подъем, и слишком много
+// спусков, прекращает просмотр сразу, поэтому на случайных данных проверка почти ничего не стоит.
+// Последняя задача волны решает: без спусков массив уже отсортирован; без подъемов — разворачивается
+// параллельно; если серий не больше max_runs — они сливаются параллельным k-путевым слиянием;
+// иначе запускается обычная сортировка (fallback) на том же состоянии.
+//
+// Слияние: значения-разделители выбираются по выборке из всех серий, границы частей в каждой серии
+// находятся двоичным поиском. Одна волна переносит куски каждой части подряд в буфер, следующая
+// сливает их за один проход деревом проигравших и записывает результат на место части в исходном массиве.
+
+namespace presorted_detail {
+
+constexpr long max_runs = 16;         // Максимум серий для слияния вместо сортировки
+constexpr long min_chunk = 1L << 16;  // Минимальная часть массива на задачу
+constexpr long samples_per_piece = 32;
+
+template <typename RandomIt, typename Compare, typename Fallback>
+struct PresortState {
+    using T = typename std::iterator_traits<RandomIt>::value_type;
+
+    ThreadPool &pool;
+    std::shared_ptr<QuicksortState> state;
+    RandomIt array;
+    long n;
+    Compare comp;
+    Fallback fallback;
+    long chunks = 1;
+    std::vector<std::vector<long>> descents; // Позиции спуска по частям (не больше max_runs + 1)
+    std::vector<char> ascending;             // Встречался ли подъем в части
+    std::vector<long> bounds;                // Границы серий: 0, ..., n
+    long pieces = 1;
+    std::vector<long> split;                 // (pieces + 1) * runs: начало части p в серии j
+    std::vector<long> out;                   // Начало части p на выходе
+    std::vector<T> buf;
+    std::atomic<long> remaining {0};
+
+    PresortState(ThreadPool &p, std::shared_ptr<QuicksortState> s, RandomIt a, long size, Compare c, Fallback f)
+        : pool(p), state(std::move(s)), array(a), n(size), comp(c), fallback(std::move(f)) {}
+
+    long runs() const { return long(bounds.size()) - 1; }
+    long chunk_begin(long c) const { return c * n / chunks; }
+};
+
+template <typename S, typename Fn>
+void run_wave(std::shared_ptr<S> st, long count, Fn fn) {
+    st->remaining.store(count);
+    for (long c = 1; c < count; ++c) {
+        spawn_task_in_pool(st->pool, st->state, [st, c, fn]() { fn(st, c); });
+    }
+    fn(st, 0);
+}
+
+template <typename S>
+bool last_of_wave(const std::shared_ptr<S> &st) {
+    return st->remaining.fetch_sub(1, std::memory_order_acq_rel) == 1;
+}
+
+// Слияние кусков серий части p, собранных подряд в буфере, одним k-путевым проходом через
+// дерево проигравших прямо в исходный массив. При равенстве раньше идет кусок из более ранней серии
+template <typename S>
+void merge_piece(std::shared_ptr<S> st, long p) {
+    using T = typename S::T;
+    long k = st->runs();
+    auto &comp = st->comp;
+    T* a = st->buf.data() + st->out[p];
+    std::vector<long> pos, end; // Текущая позиция и конец каждого непустого куска относительно начала части
+    long total = 0;
+    for (long j = 0; j < k; ++j) {
+        long len = st->split[(p + 1) * k + j] - st->split[p * k + j];
+        if (len == 0) continue;
+        pos.push_back(total);
+        total += len;
+        end.push_back(total);
+    }
+    if (pos.empty()) return;
+    auto beats = [&](long x, long y) {
+        if (pos[x] == end[x]) return false;
+        if (pos[y] == end[y]) return true;
+        if (comp(a[pos[x]], a[pos[y]])) return true;
+        if (comp(a[pos[y]], a[pos[x]])) return false;
+        return x < y;
+    };
+    LoserTree<decltype(beats)> tree(long(pos.size()), beats);
+    auto dst = st->array + st->out[p];
+    for (long i = 0; i < total; ++i) {
+        long w = tree.winner();
+        dst[i] = std::move(a[pos[w]++]);
+        tree.replay();
+    }
+}
+
+// Перенос кусков серий, относящихся к части p, подряд в буфер (исходный массив затем перезаписывается)
+template <typename S>
+void gather_piece(std::shared_ptr<S> st, long p) {
+    long k = st->runs();
+    auto dst = st->buf.begin() + st->out[p];
+    for (long j = 0; j < k; ++j) {
+        dst = std::move(st->array + st->split[p * k + j], st->array + st->split[(p + 1) * k + j], dst);
+    }
+    if (last_of_wave(st)) run_wave(st, st->pieces, merge_piece<S>);
+}
+
+// Выбор разделителей и границ частей слияния
+template <typename S>
+void start_merge(std::shared_ptr<S> st) {
+    using T = typename S::T;
+    long k = st->runs();
+    auto array = st->array;
+    auto &comp = st->comp;
+    st->pieces = std::clamp(st->n / min_chunk, 1L, long(st->pool.size()));
+    long P = st->pieces;
+    st->split.assign((P + 1) * k, 0);
+    for (long j = 0; j < k; ++j) {
+        st->split[j] = st->bounds[j];
+        st->split[P * k + j] = st->bounds[j + 1];
+    }
+    if (P > 1) {
+        // Выборка из серий пропорционально их длине
+        std::vector<T> sample;
+        for (long j = 0; j < k; ++j) {
+            long len = st->bounds[j + 1] - st->bounds[j];
+            long count = 1 + samples_per_piece * P * len / st->n;
+            for (long s = 0; s < count; ++s) sample.push_back(array[st->bounds[j] + s * len / count]);
+        }
+        std::sort(sample.begin(), sample.end(), comp);
+        for (long p = 1; p < P; ++p) {
+            const T &splitter = sample[p * long(sample.size()) / P];
+            for (long j = 0; j < k; ++j) {
+                st->split[p * k + j] = long(std::lower_bound(array + st->bounds[j], array + st->bounds[j + 1],
+                                                             splitter, comp) - array);
+            }
+        }
+    }
+    st->out.assign(P + 1, 0);
+    for (long p = 0; p < P; ++p) {
+        long size = 0;
+        for (long j = 0; j < k; ++j) size += st->split[(p + 1) * k + j] - st->split[p * k + j];
+        st->out[p + 1] = st->out[p] + size;
+    }
+    st->buf.resize(st->n);
+    run_wave(st, P, gather_piece<S>);
+}
+
+// Разворот части c: меняются местами элементы первой половины и зеркальные им
+template <typename S>
+void reverse_chunk(std::shared_ptr<S> st, long c) {
+    long half = st->n / 2;
+    for (long i = c * half / st->chunks, e = (c + 1) * half / st->chunks; i < e; ++i) {
+        std::iter_swap(st->array + i, st->array + (st->n - 1 - i));
+    }
+}
+
+// Поиск спусков и подъемов в части c; последняя задача выбирает дальнейший путь
+template <typename S>
+void scan_chunk(std::shared_ptr<S> st, long c) {
+    auto array = st->array;
+    auto &comp = st->comp;
+    auto &desc = st->descents[c];
+    bool asc = false;
+    for (long i = std::max(1L, st->chunk_begin(c)), e = st->chunk_begin(c + 1); i < e; ++i) {
+        if (comp(array[i], array[i - 1])) {
+            if (long(desc.size()) <= max_runs) desc.push_back(i);
+            if (asc && long(desc.size()) > max_runs) break;
+        } else if (!asc && comp(array[i - 1], array[i])) {
+            asc = true;
+            if (long(desc.size()) > max_runs) break;
+        }
+    }
+    st->ascending[c] = asc;
+    if (!last_of_wave(st)) return;
+
+    long total = 0;
+    bool any_ascent = false;
+    for (long q = 0; q < st->chunks; ++q) {
+        total += long(st->descents[q].size());
+        any_ascent = any_ascent || st->ascending[q];
+    }
+    if (total == 0) return; // Уже отсортирован
+    if (!any_ascent) {
+        run_wave(st, st->chunks, reverse_chunk<S>);
+    } else if (total < max_runs) {
+        st->bounds.push_back(0);
+        for (auto &d : st->descents) st->bounds.insert(st->bounds.end(), d.begin(), d.end());
+        st->bounds.push_back(st->n);
+        start_merge(st);
+    } else {
+        st->fallback();
+    }
+}
+
+} // namespace presorted_detail
+
+// Сортировка участка [left, right] с распознаванием упорядоченности на существующем состоянии.
+// fallback() вызывается в задаче пула, если данные не упорядочены, и должен отсортировать участок сам
+template <typename RandomIt, typename Compare, typename Fallback>
+void presorted_job(ThreadPool &pool, RandomIt array, long left, long right, std::shared_ptr<QuicksortState> state,
+                   Compare comp, Fallback fallback) {
+    using namespace presorted_detail;
+    using S = PresortState<RandomIt, Compare, Fallback>;
+    long n = right - left + 1;
+    if (n < 2) return;
+    auto st = std::make_shared<S>(pool, std::move(state), array + left, n, comp, std::move(fallback));
+    st->chunks = std::clamp(n / min_chunk, 1L, long(pool.size()));
+    st->descents.resize(st->chunks);
+    st->ascending.assign(st->chunks, 0);
+    run_wave(st, st->chunks, scan_chunk<S>);
+}
+
+// Асинхронная сортировка с распознаванием упорядоченности: отсортированный участок возвращается сразу,
+// убывающий разворачивается, несколько серий сливаются, остальное сортируется быстрой сортировкой
+template <typename RandomIt, typename Compare = std::less<>>
+std::future<void> presorted_sort_async(ThreadPool &pool, RandomIt array, long left, long right, long threshold = 100000,
+                                       const QuicksortOptions &opts = {}, Compare comp = {}) {
+    auto state = std::make_shared<QuicksortState>();
+    state->opts = opts;
+    spawn_task_in_pool(pool, state, [=, &pool]() {
+        presorted_job(pool, array, left, right, state, comp, [=, &pool]() {
+            quicksort_job(pool, array, left, right, state, threshold, comp);
+        });
+    });
+    return state->prom->get_future();
+}
@@ -0,0 +1,170 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <vector>
+#include "ThreadPool.h"
+#include "Quicksort.h"
+
+
+
+// Быстрая сортировка с постепенной выдачей результата: отсортированный префикс растет во время работы.
+//
+// Каждый участок, занявший окончательное место (отсортированный лист или отрезок, равный опорному
+// элементу), отмечается в трекере. Трекер хранит отмеченные отрезки правее границы и сдвигает
+// границу ("отсортировано до индекса i"), как только к ней примыкает отмеченный отрезок.
+// Граница только растет; при каждом сдвиге вызывается необязательный обработчик, а потребители
+// могут ждать нужную границу через wait_for.
+//
+// Чтобы граница росла как можно раньше, задача после разбиения продолжает левую часть сама,
+// а большую правую кладет в общую очередь с приоритетом по левому краю. На каждый отложенный
+// участок в пул ставится одна задача-исполнитель, которая берет самый левый участок из очереди,
+// а не обязательно тот, ради которого была создана.
+
+// Состояние отсортированного префикса
+class SortProgress {
+public:
+    SortProgress(long begin, long end, std::function<void(long)> on_progress)
+        : watermark_(begin), end_(end), on_progress_(std::move(on_progress)) {}
+
+    // Все позиции левее watermark() уже на своих местах
+    long watermark() const { return watermark_.load(std::memory_order_acquire); }
+
+    // Дождаться, пока граница достигнет index (или сортировка завершится с ошибкой).
+    // Возвращает false при ошибке сортировки
+    bool wait_for(long index) {
+        index = std::min(index, end_);
+        std::unique_lock<std::mutex> lock(mtx_);
+        cv_.wait(lock, [&] { return watermark_.load(std::memory_order_relaxed) >= index || failed_; });
+        return watermark_.load(std::memory_order_relaxed) >= index;
+    }
+
+    // Отметить, что [b, e] занял окончательное место
+    void mark_done(long b, long e) {
+        if (b > e) return;
+        std::lock_guard<std::mutex> lock(mtx_);
+        long w = watermark_.load(std::memory_order_relaxed);
+        if (b != w) {
+            done_.emplace(b, e);
+            return;
+        }
+        w = e + 1;
+        for (auto it = done_.begin(); it != done_.end() && it->first == w; it = done_.erase(it)) w = it->second + 1;
+        watermark_.store(w, std::memory_order_release);
+        if (on_progress_) on_progress_(w); // Под блокировкой: вызовы идут по возрастанию границы
+        cv_.notify_all();
+    }
+
+    void fail() {
+        std::lock_guard<std::mutex> lock(mtx_);
+        failed_ = true;
+        cv_.notify_all();
+    }
+
+private:
+    std::atomic<long> watermark_;
+    long end_;
+    std::function<void(long)> on_progress_;
+    std::mutex mtx_;
+    std::condition_variable cv_;
+    std::map<long, long> done_; // Отмеченные отрезки правее границы: начало -> конец
+    bool failed_ = false;
+};
+
+// Результат запуска: future завершения и доступ к растущему префиксу
+struct ProgressiveSort {
+    std::future<void> done;
+    std::shared_ptr<SortProgress> progress;
+};
+
+namespace progressive_detail {
+
+template <typename RandomIt, typename Compare>
+struct ProgressiveState {
+    ThreadPool &pool;
+    std::shared_ptr<QuicksortState> state;
+    std::shared_ptr<SortProgress> progress;
+    RandomIt array;
+    long threshold;
+    Compare comp;
+    std::mutex mtx;
+    std::priority_queue<std::pair<long, long>, std::vector<std::pair<long, long>>, std::greater<>> pending; // Самый левый сверху
+
+    ProgressiveState(ThreadPool &p, std::shared_ptr<QuicksortState> s, std::shared_ptr<SortProgress> pr, RandomIt a,
+                     long thr, Compare c)
+        : pool(p), state(std::move(s)), progress(std::move(pr)), array(a), threshold(thr), comp(c) {}
+};
+
+template <typename S> void run_leftmost(std::shared_ptr<S> st);
+
+// Отсортировать [left, right]: левая часть — сразу, большие правые — в очередь по приоритету
+template <typename S>
+void sort_segment(const std::shared_ptr<S> &st, long left, long right) {
+    const QuicksortOptions &opts = st->state->opts;
+    while (right - left >= opts.leaf_size) {
+        auto [r, l] = partition_step(st->array, left, right, opts, st->threshold, st->comp);
+        st->progress->mark_done(r + 1, l - 1); // Отрезок, равный опорному элементу
+        if (right - l > st->threshold) {
+            {
+                std::lock_guard<std::mutex> lock(st->mtx);
+                st->pending.emplace(l, right);
+            }
+            spawn_task_in_pool(st->pool, st->state, [st]() { run_leftmost(st); });
+        } else {
+            sort_segment(st, left, r);
+            left = l;
+            continue;
+        }
+        right = r;
+    }
+    if (left <= right) {
+        leaf_sort(st->array + left, right - left + 1, opts.leaf, st->comp);
+        st->progress->mark_done(left, right);
+    }
+}
+
+// Задача-исполнитель: взять самый левый отложенный участок
+template <typename S>
+void run_leftmost(std::shared_ptr<S> st) {
+    long left, right;
+    {
+        std::lock_guard<std::mutex> lock(st->mtx);
+        std::tie(left, right) = st->pending.top();
+        st->pending.pop();
+    }
+    try {
+        sort_segment(st, left, right);
+    } catch (...) {
+        st->progress->fail();
+        throw;
+    }
+}
+
+} // namespace progressive_detail
+
+// Асинхронная сортировка [left, right] с растущим отсортированным префиксом.
+// on_progress(i) вызывается из потоков пула при каждом сдвиге границы (позиции левее i готовы)
+template <typename RandomIt, typename Compare = std::less<>>
+ProgressiveSort progressive_sort_async(ThreadPool &pool, RandomIt array, long left, long right, long threshold = 100000,
+                                       const QuicksortOptions &opts = {}, Compare comp = {},
+                                       std::function<void(long)> on_progress = {}) {
+    using namespace progressive_detail;
+    using S = ProgressiveState<RandomIt, Compare>;
+    auto state = std::make_shared<QuicksortState>();
+    state->opts = opts;
+    auto progress = std::make_shared<SortProgress>(left, std::max(left, right + 1), std::move(on_progress));
+    auto st = std::make_shared<S>(pool, state, progress, array, threshold, comp);
+    if (right >= left) {
+        st->pending.emplace(left, right);
+        spawn_task_in_pool(pool, state, [st]() { run_leftmost(st); });
+    } else {
+        spawn_task_in_pool(pool, state, []() {});
+    }
+    return {state->prom->get_future(), progress};
+}
@@ -0,0 +1,187 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include "ThreadPool.h"
+#include "Pivot.h"
+#include "Partition.h"
+#include "SimdPartition.h"
+#include "LeafSort.h"
+
+
+
+// Настройки быстрой сортировки
+struct QuicksortOptions {
+    PivotStrategy pivot = PivotStrategy::Ninther; // Стратегия выбора опорного элемента
+    PartitionMode partition = PartitionMode::Auto; // Режим разбиения (двух- или трехчастное)
+    PartitionKernel kernel = PartitionKernel::Loop; // Ядро двухчастного разбиения
+    long leaf_size = 1000; // Порог для сортировки маленьких участков без разбиения
+    LeafAlgorithm leaf = LeafAlgorithm::Network; // Алгоритм сортировки маленьких участков (сети — для int, unsigned и float)
+    PartitionStats* stats = nullptr; // Статистика разбиений (если nullptr — не собирается)
+    std::shared_ptr<PoolJob> job; // Задание пула для справедливого планирования и статистики (если nullptr — без задания)
+};
+
+// Структура для отслеживания состояния быстрой сортировки
+struct QuicksortState {
+    std::shared_ptr<std::promise<void>> prom; //  для ожидания завершения сортировки (nullptr после restart())
+    std::shared_ptr<std::atomic<int>> counter; // Счетчик активных задач
+    std::shared_ptr<std::exception_ptr> except_ptr; // Указатель на исключение
+    std::shared_ptr<std::mutex> except_mtx; // Мьютекс для обработки исключений
+    std::shared_ptr<bool> except_set; // Флаг, что исключение уже установлено
+    std::atomic<bool> done{false}; // Все задачи завершены (отмечается и при наличии promise)
+    QuicksortOptions opts; // Настройки сортировки
+
+    QuicksortState()
+        : prom(std::make_shared<std::promise<void>>()),
+          counter(std::make_shared<std::atomic<int>>(0)),
+          except_ptr(std::make_shared<std::exception_ptr>()),
+          except_mtx(std::make_shared<std::mutex>()),
+          except_set(std::make_shared<bool>(false))
+    {}
+
+    // Подготовить состояние к новому запуску без promise: завершение ждется через wait().
+    // Ничего не выделяет, поэтому владелец состояния переиспользует его между сортировками.
+    // Вызывать, когда задачи предыдущего запуска завершены
+    void restart() {
+        std::lock_guard<std::mutex> l(*except_mtx);
+        prom.reset();
+        *except_ptr = nullptr;
+        *except_set = false;
+        done.store(false, std::memory_order_relaxed);
+    }
+
+    // Дождаться завершения всех задач запуска и пробросить исключение первой упавшей задачи
+    void wait() {
+        done.wait(false, std::memory_order_acquire);
+        std::lock_guard<std::mutex> l(*except_mtx);
+        if (*except_set) std::rethrow_exception(*except_ptr);
+    }
+};
+
+// Запустить задачу сортировки в пуле потоков и увеличить счетчик активных задач.
+// Функциональный объект задачи переносится в задачу пула как есть, без обертки std::function
+template <typename Job>
+void spawn_task_in_pool(ThreadPool &pool, std::shared_ptr<QuicksortState> state, Job job) {
+    state->counter->fetch_add(1, std::memory_order_relaxed); // Увеличиваем счетчик задач
+    pool.push_task([state, job = std::move(job)]() mutable {
+        try {
+            job(); // Выполняем задачу сортировки
+        } catch(...) {
+            // Если возникло исключение, сохраняем его
+            std::lock_guard<std::mutex> l(*state->except_mtx);
+            if (!*state->except_set) {
+                *state->except_ptr = std::current_exception();
+                *state->except_set = true;
+            }
+        }
+        // Уменьшаем счетчик задач, если все задачи завершены — завершаем promise и отмечаем done
+        int prev = state->counter->fetch_sub(1, std::memory_order_acq_rel);
+        if (prev == 1) {
+            std::lock_guard<std::mutex> l(*state->except_mtx);
+            if (state->prom) {
+                if (*state->except_set) {
+                    state->prom->set_exception(*state->except_ptr);
+                } else {
+                    state->prom->set_value();
+                }
+            }
+            state->done.store(true, std::memory_order_release);
+            state->done.notify_all();
+        }
+    }, state->opts.job); // Задача попадает в очередь задания, если оно задано
+}
+
+// Один шаг разбиения участка [left, right] с настройками opts: выбор опорного элемента, режима
+// и ядра разбиения. Для указателей на арифметические типы с порядком "<" на этапе компиляции
+// подключаются блочное и векторное ядра; для остальных итераторов и компараторов используется
+// обобщенный путь, где компаратор — параметр шаблона и встраивается во внутренний цикл.
+template <typename RandomIt, typename Compare = std::less<>>
+PartitionResult partition_step(RandomIt array, long left, long right, const QuicksortOptions &opts, long sample_cutoff,
+                               Compare comp = {}) {
+    auto pivot = select_pivot(array, left, right, opts.pivot, sample_cutoff, comp);
+    PartitionMode mode = opts.partition;
+    if (mode == PartitionMode::Auto) {
+        mode = has_many_duplicates(array, left, right, comp) ? PartitionMode::ThreeWay : PartitionMode::Hoare;
+    }
+    PartitionResult parts;
+    if (mode == PartitionMode::ThreeWay) {
+        parts = partition_three_way(array, left, right, pivot, comp);
+    } else if constexpr (uses_fast_kernels_v<RandomIt, Compare>) {
+        using T = std::remove_pointer_t<RandomIt>;
+        if (opts.kernel == PartitionKernel::Simd && std::is_same_v<T, int>) {
+            if constexpr (std::is_same_v<T, int>) parts = partition_simd(array, left, right, pivot);
+        } else if (opts.kernel != PartitionKernel::Loop) {
+            parts = partition_block(array, left, right, pivot);
+        } else {
+            parts = partition_hoare(array, left, right, pivot);
+        }
+    } else {
+        parts = partition_hoare(array, left, right, pivot, comp);
+    }
+    if (opts.stats) opts.stats->record(right - left + 1, std::min(parts.r - left + 1, right - parts.l + 1));
+    return parts;
+}
+
+// Рекурсивная задача быстрой сортировки для пула потоков
+template <typename RandomIt, typename Compare = std::less<>>
+void quicksort_job(ThreadPool &pool, RandomIt array, long left, long right, std::shared_ptr<QuicksortState> state, long threshold,
+                   Compare comp = {}) {
+    if (left >= right) return;
+    if (right - left < state->opts.leaf_size) {
+        leaf_sort(array + left, right - left + 1, state->opts.leaf, comp); // Сортируем маленький участок
+        return;
+    }
+
+    // Разбиение массива
+    auto [r, l] = partition_step(array, left, right, state->opts, threshold, comp);
+
+    // Определяем, стоит ли запускать подзадачи параллельно
+    bool left_big = (r - left) > threshold;
+    bool right_big = (right - l) > threshold;
+
+    // Запускаем подзадачи в пуле потоков, если участок достаточно большой
+    if (left_big && right_big) {
+        spawn_task_in_pool(pool, state, [=, &pool]() {
+            quicksort_job(pool, array, left, r, state, threshold, comp);
+        });
+        if (state->opts.job && pool.should_yield(state->opts.job)) {
+            // Другие задания ждут потоков: правую часть тоже в очередь, чтобы планировщик выбрал по справедливости
+            spawn_task_in_pool(pool, state, [=, &pool]() {
+                quicksort_job(pool, array, l, right, state, threshold, comp);
+            });
+        } else {
+            quicksort_job(pool, array, l, right, state, threshold, comp);
+        }
+    } else if (left_big) {
+        spawn_task_in_pool(pool, state, [=, &pool]() {
+            quicksort_job(pool, array, left, r, state, threshold, comp);
+        });
+        quicksort_job(pool, array, l, right, state, threshold, comp);
+    } else if (right_big) {
+        spawn_task_in_pool(pool, state, [=, &pool]() {
+            quicksort_job(pool, array, l, right, state, threshold, comp);
+        });
+        quicksort_job(pool, array, left, r, state, threshold, comp);
+    } else {
+        // Если участок маленький, сортируем оба участка последовательно
+        quicksort_job(pool, array, left, r, state, threshold, comp);
+        quicksort_job(pool, array, l, right, state, threshold, comp);
+    }
+}
+
+// Асинхронный запуск быстрой сортировки через пул потоков
+template <typename RandomIt, typename Compare = std::less<>>
+std::future<void> quicksort_async(ThreadPool &pool, RandomIt array, long left, long right, long threshold = 100000,
+                                  const QuicksortOptions &opts = {}, Compare comp = {}) {
+    auto state = std::make_shared<QuicksortState>(); // Создаем объект состояния сортировки
+    state->opts = opts;
+    // Запускаем корневую задачу сортировки
+    spawn_task_in_pool(pool, state, [=, &pool]() {
+        quicksort_job(pool, array, left, right, state, threshold, comp);
+    });
+    return state->prom->get_future(); // Возвращаем future для ожидания завершения сортировки
+}
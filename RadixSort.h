@@ -0,0 +1,516 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <type_traits>
+#include <vector>
+#include "Quicksort.h"
+
+
+
+// Параллельная поразрядная сортировка LSD для целых и вещественных ключей.
+//
+// Каждый проход по разряду — три волны задач пула: подсчет гистограмм по частям массива,
+// суммы по столбцам (каждая задача для своего диапазона корзин находит смещения частей внутри
+// корзины и размер корзины) и раскладка элементов по вычисленным смещениям. Последовательно,
+// в последней задаче второй волны, считаются только начала 2^bits корзин.
+// Раскладка идет через программные буферы объединения записи (по 64 байта на корзину),
+// чтобы запись в память шла целыми строками кэша. Проходы, где все ключи попадают в одну корзину,
+// пропускаются. Сортировка устойчива и требует буфер на n элементов, который можно передать снаружи.
+
+namespace radix_detail {
+
+template <size_t Size> struct UnsignedOf;
+template <> struct UnsignedOf<1> { using type = uint8_t; };
+template <> struct UnsignedOf<2> { using type = uint16_t; };
+template <> struct UnsignedOf<4> { using type = uint32_t; };
+template <> struct UnsignedOf<8> { using type = uint64_t; };
+
+} // namespace radix_detail
+
+// Беззнаковый ключ того же размера, что и T
+template <typename T>
+using radix_key_t = typename radix_detail::UnsignedOf<sizeof(T)>::type;
+
+// Преобразование ключа в беззнаковое число с тем же порядком:
+// для знаковых целых инвертируется знаковый бит, для IEEE-чисел отрицательные инвертируются целиком.
+// NaN упорядочиваются по своему битовому представлению (за бесконечностями своего знака).
+template <typename T>
+radix_key_t<T> radix_key(T x) {
+    static_assert(std::is_arithmetic_v<T> && !std::is_same_v<T, bool>, "radix_key поддерживает только числовые типы");
+    using U = radix_key_t<T>;
+    constexpr U sign = U(U(1) << (sizeof(T) * 8 - 1));
+    if constexpr (std::is_floating_point_v<T>) {
+        U u = std::bit_cast<U>(x);
+        return (u & sign) ? U(~u) : U(u | sign);
+    } else if constexpr (std::is_signed_v<T>) {
+        return U(U(x) ^ sign);
+    } else {
+        return U(x);
+    }
+}
+
+namespace radix_detail {
+
+// Общее состояние сортировки между волнами задач
+template <typename T>
+struct RadixState {
+    ThreadPool &pool;
+    std::shared_ptr<QuicksortState> state;
+    T* array;
+    T* src;
+    T* dst;
+    std::vector<T> owned_scratch;  // Буфер, если пользователь не передал свой
+    long n = 0;
+    int bits = 8;
+    int low_bit = 0;               // Младший сортируемый бит ключа
+    int passes = 0;
+    int pass = 0;
+    long chunks = 1;
+    std::vector<long> hist;        // chunks * 2^bits: счетчики, затем смещения внутри корзин
+    std::vector<long> totals;      // 2^bits: размеры корзин, затем их начала
+    std::vector<T> combine;        // chunks * 2^bits * line: буферы объединения записи частей
+    std::vector<unsigned char> combine_fill; // chunks * 2^bits: заполнение этих буферов
+    std::atomic<long> remaining {0};
+
+    static constexpr long line = std::max<long>(1, 64 / long(sizeof(T))); // Элементов в строке кэша
+
+    RadixState(ThreadPool &p, std::shared_ptr<QuicksortState> s) : pool(p), state(std::move(s)) {}
+
+    long radix() const { return long(1) << bits; }
+    long chunk_begin(long c) const { return c * n / chunks; }
+};
+
+template <typename T> void launch_pass(std::shared_ptr<RadixState<T>> st);
+
+// Запустить волну из st->chunks задач; задача 0 выполняется в текущем потоке
+template <typename T, typename Fn>
+void run_wave(std::shared_ptr<RadixState<T>> st, Fn fn) {
+    st->remaining.store(st->chunks);
+    for (long c = 1; c < st->chunks; ++c) {
+        spawn_task_in_pool(st->pool, st->state, [st, c, fn]() { fn(st, c); });
+    }
+    fn(st, 0);
+}
+
+// Раскладка части c по корзинам через буферы объединения записи
+template <typename T>
+void scatter_chunk(std::shared_ptr<RadixState<T>> st, long c) {
+    constexpr long line = RadixState<T>::line;
+    long R = st->radix();
+    long* offset = st->hist.data() + c * R;
+    const long* start = st->totals.data();
+    for (long d = 0; d < R; ++d) offset[d] += start[d];
+    T* wc = st->combine.data() + c * R * line;
+    unsigned char* count = st->combine_fill.data() + c * R;
+    std::fill(count, count + R, 0);
+    const T* src = st->src;
+    T* dst = st->dst;
+    const int shift = st->low_bit + st->pass * st->bits;
+    const size_t mask = size_t(R - 1);
+    for (long i = st->chunk_begin(c), end = st->chunk_begin(c + 1); i < end; ++i) {
+        size_t d = size_t(radix_key(src[i]) >> shift) & mask;
+        T* buf = wc + d * line;
+        buf[count[d]++] = src[i];
+        if (count[d] == line) {
+            std::copy(buf, buf + line, dst + offset[d]);
+            offset[d] += line;
+            count[d] = 0;
+        }
+    }
+    for (long d = 0; d < R; ++d) {
+        std::copy(wc + d * line, wc + d * line + count[d], dst + offset[d]);
+    }
+    if (st->remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        std::swap(st->src, st->dst);
+        ++st->pass;
+        launch_pass(st);
+    }
+}
+
+// Начала корзин по их размерам и запуск раскладки
+template <typename T>
+void bucket_starts(std::shared_ptr<RadixState<T>> st) {
+    long R = st->radix();
+    long running = 0;
+    for (long d = 0; d < R; ++d) {
+        long total = st->totals[d];
+        if (total == st->n) {
+            // Все ключи имеют одинаковый разряд — проход ничего не меняет
+            ++st->pass;
+            launch_pass(st);
+            return;
+        }
+        st->totals[d] = running;
+        running += total;
+    }
+    run_wave(st, scatter_chunk<T>);
+}
+
+// Суммы по столбцам для корзин задачи c: счетчик каждой части заменяется числом элементов
+// той же корзины в частях левее, размер корзины записывается в totals
+template <typename T>
+void column_sums(std::shared_ptr<RadixState<T>> st, long c) {
+    long R = st->radix();
+    for (long d = c * R / st->chunks, end = (c + 1) * R / st->chunks; d < end; ++d) {
+        long running = 0;
+        for (long k = 0; k < st->chunks; ++k) {
+            long cnt = st->hist[k * R + d];
+            st->hist[k * R + d] = running;
+            running += cnt;
+        }
+        st->totals[d] = running;
+    }
+    if (st->remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) bucket_starts(st);
+}
+
+// Подсчет гистограммы разряда для части c
+template <typename T>
+void histogram_chunk(std::shared_ptr<RadixState<T>> st, long c) {
+    long R = st->radix();
+    long* h = st->hist.data() + c * R;
+    std::fill(h, h + R, 0);
+    const T* src = st->src;
+    const int shift = st->low_bit + st->pass * st->bits;
+    const size_t mask = size_t(R - 1);
+    for (long i = st->chunk_begin(c), end = st->chunk_begin(c + 1); i < end; ++i) {
+        ++h[size_t(radix_key(src[i]) >> shift) & mask];
+    }
+    if (st->remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) run_wave(st, column_sums<T>);
+}
+
+// Копирование части c обратно в исходный массив после нечетного числа проходов
+template <typename T>
+void copy_back_chunk(std::shared_ptr<RadixState<T>> st, long c) {
+    std::copy(st->src + st->chunk_begin(c), st->src + st->chunk_begin(c + 1), st->array + st->chunk_begin(c));
+}
+
+template <typename T>
+void launch_pass(std::shared_ptr<RadixState<T>> st) {
+    if (st->pass < st->passes) {
+        run_wave(st, histogram_chunk<T>);
+    } else if (st->src != st->array) {
+        run_wave(st, copy_back_chunk<T>);
+    }
+}
+
+// Подготовить состояние к сортировке участка [left, right]; векторы сохраняют емкость между запусками
+template <typename T>
+void prepare(RadixState<T> &st, T* array, long left, long right, T* scratch, int radix_bits, int low_bit) {
+    st.n = std::max(0L, right - left + 1);
+    st.array = array + left;
+    st.src = st.array;
+    if (!scratch) {
+        st.owned_scratch.resize(st.n);
+        scratch = st.owned_scratch.data();
+    }
+    st.dst = scratch;
+    st.bits = std::clamp(radix_bits, 1, 16);
+    st.low_bit = std::clamp(low_bit, 0, int(sizeof(T) * 8));
+    st.passes = int((sizeof(T) * 8 - st.low_bit + st.bits - 1) / st.bits);
+    st.pass = 0;
+    st.chunks = std::clamp(st.n / (long(1) << 16), 1L, long(st.pool.size()));
+    st.hist.resize(st.chunks * st.radix());
+    st.totals.resize(st.radix());
+    st.combine.resize(st.chunks * st.radix() * RadixState<T>::line);
+    st.combine_fill.resize(st.chunks * st.radix());
+}
+
+} // namespace radix_detail
+
+// Переиспользуемая память поразрядной сортировки: состояние с гистограммами и буферами
+// объединения записи. Повторный запуск с тем же размером участка и разрядностью не выделяет память
+template <typename T>
+struct RadixWorkspace {
+    std::optional<radix_detail::RadixState<T>> st;
+};
+
+// Асинхронная поразрядная сортировка участка [left, right] через пул потоков.
+// scratch — буфер не меньше right - left + 1 элементов; если nullptr, выделяется внутри.
+// radix_bits — разрядов на проход (обычно 8 или 11).
+// low_bit — младший сортируемый бит ключа: биты ниже него не участвуют в сравнении, и элементы,
+// равные по старшим битам, сохраняют исходный порядок (проходы по младшим битам не выполняются).
+template <typename T>
+std::future<void> radix_sort_async(ThreadPool &pool, T* array, long left, long right, T* scratch = nullptr,
+                                   int radix_bits = 8, int low_bit = 0) {
+    using namespace radix_detail;
+    auto state = std::make_shared<QuicksortState>();
+    auto st = std::make_shared<RadixState<T>>(pool, state);
+    prepare(*st, array, left, right, scratch, radix_bits, low_bit);
+    spawn_task_in_pool(pool, state, [st]() { launch_pass(st); });
+    return state->prom->get_future();
+}
+
+// Вариант с состоянием и памятью вызывающего: задачи запускаются на state (его готовят restart()
+// и дожидаются wait()), гистограммы и буферы берутся из ws. scratch — буфер не меньше участка.
+template <typename T>
+void radix_sort_async(ThreadPool &pool, T* array, long left, long right, std::shared_ptr<QuicksortState> state,
+                      RadixWorkspace<T> &ws, T* scratch, int radix_bits = 8, int low_bit = 0) {
+    using namespace radix_detail;
+    if (!ws.st || &ws.st->pool != &pool) {
+        ws.st.emplace(pool, state);
+    } else {
+        ws.st->state = state;
+    }
+    prepare(*ws.st, array, left, right, scratch, radix_bits, low_bit);
+    std::shared_ptr<RadixState<T>> st(state, &*ws.st);
+    spawn_task_in_pool(pool, state, [st]() { launch_pass(st); });
+}
+
+
+// Параллельная поразрядная сортировка MSD на месте (American flag / PARADIS).
+//
+// Дополнительная память — только гистограммы и указатели отрезков по потокам. Уровень рекурсии:
+// параллельный подсчет гистограмм старшего разряда, затем раунды перестановки: неразмещенная часть
+// каждой корзины делится между потоками, каждый поток переставляет элементы только внутри своих
+// отрезков (элементы, которым не хватило места, остаются "застрявшими"), после чего задачи починки
+// меняют застрявшие элементы корзины на ее же элементы из хвоста. Раунды повторяются, пока
+// все элементы не займут свои корзины; однопоточный раунд размещает все за один проход.
+// Корзины рекурсивно сортируются по следующему разряду задачами пула, маленькие — сравнением.
+
+namespace msd_detail {
+
+constexpr int digit_bits = 8;
+constexpr long radix = long(1) << digit_bits;
+constexpr long min_part = long(1) << 16; // Минимум неразмещенных элементов на поток в раунде
+
+template <typename T>
+inline long digit(const T& x, int shift) {
+    return long(radix_key(x) >> shift) & (radix - 1);
+}
+
+// Перестановка в пределах отрезков [head[i], tail[i]) каждой корзины i.
+// После нее [исходный head[i], head[i]) занимают элементы корзины i, а [head[i], tail[i)) — чужие
+template <typename T>
+void permute_parts(T* a, long* head, const long* tail, int shift) {
+    for (long i = 0; i < radix; ++i) {
+        long pos = head[i];
+        while (pos < tail[i]) {
+            T v = std::move(a[pos]);
+            long k = digit(v, shift);
+            while (k != i && head[k] < tail[k]) {
+                std::swap(v, a[head[k]++]);
+                k = digit(v, shift);
+            }
+            if (k == i) {
+                if (head[i] != pos) a[pos] = std::move(a[head[i]]);
+                a[head[i]++] = std::move(v);
+            } else {
+                a[pos] = std::move(v);
+            }
+            ++pos;
+        }
+    }
+}
+
+// Последовательная сортировка American flag участка [b, e) начиная с разряда shift
+template <typename T>
+void msd_sequential(T* a, long b, long e, int shift, const QuicksortOptions &opts) {
+    while (true) {
+        long n = e - b;
+        if (n <= opts.leaf_size) {
+            leaf_sort(a + b, n, opts.leaf);
+            return;
+        }
+        long count[radix] = {};
+        for (long i = b; i < e; ++i) ++count[digit(a[i], shift)];
+        long head[radix], tail[radix];
+        long pos = b;
+        bool trivial = false;
+        for (long i = 0; i < radix; ++i) {
+            head[i] = pos;
+            pos += count[i];
+            tail[i] = pos;
+            if (count[i] == n) trivial = true;
+        }
+        if (!trivial) {
+            permute_parts(a, head, tail, shift);
+            if (shift == 0) return;
+            long start = b;
+            for (long i = 0; i < radix; ++i) {
+                if (count[i] > 1) msd_sequential(a, start, start + count[i], shift - digit_bits, opts);
+                start += count[i];
+            }
+            return;
+        }
+        // Все ключи имеют одинаковый разряд — сразу переходим к следующему
+        if (shift == 0) return;
+        shift -= digit_bits;
+    }
+}
+
+// Состояние одного параллельного уровня рекурсии
+template <typename T>
+struct MsdStep {
+    ThreadPool &pool;
+    std::shared_ptr<QuicksortState> state;
+    T* a;
+    long b, e, threshold;
+    int shift;
+    long threads = 1;                 // Потоков в текущей волне
+    long last_unplaced = -1;
+    std::vector<long> count;          // Гистограммы по потокам (threads * radix)
+    std::vector<long> head, tail;     // Отрезки потоков в корзинах (threads * radix)
+    long bucket_start[radix + 1];
+    long gh[radix];                   // Начало неразмещенной части каждой корзины
+    std::atomic<long> remaining {0};
+
+    MsdStep(ThreadPool &p, std::shared_ptr<QuicksortState> s, T* array, long begin, long end, long thr, int sh)
+        : pool(p), state(std::move(s)), a(array), b(begin), e(end), threshold(thr), shift(sh) {}
+};
+
+template <typename T> void start_round(std::shared_ptr<MsdStep<T>> step);
+
+// Запустить волну из step->threads задач; задача 0 выполняется в текущем потоке
+template <typename T, typename Fn>
+void run_wave(std::shared_ptr<MsdStep<T>> step, Fn fn) {
+    step->remaining.store(step->threads);
+    for (long p = 1; p < step->threads; ++p) {
+        spawn_task_in_pool(step->pool, step->state, [step, p, fn]() { fn(step, p); });
+    }
+    fn(step, 0);
+}
+
+} // namespace msd_detail
+
+// Рекурсивная задача MSD-сортировки участка [left, right] начиная с разряда shift
+template <typename T>
+void msd_radix_job(ThreadPool &pool, T* array, long left, long right, std::shared_ptr<QuicksortState> state,
+                   long threshold, int shift = int(sizeof(T) * 8) - msd_detail::digit_bits) {
+    using namespace msd_detail;
+    long n = right - left + 1;
+    if (n <= threshold) {
+        msd_sequential(array, left, right + 1, shift, state->opts);
+        return;
+    }
+    auto step = std::make_shared<MsdStep<T>>(pool, state, array, left, right + 1, threshold, shift);
+    step->threads = std::clamp(n / min_part, 1L, long(pool.size()));
+    step->count.assign(step->threads * radix, 0);
+    run_wave(step, [](std::shared_ptr<MsdStep<T>> st, long p) {
+        long n = st->e - st->b;
+        long* h = st->count.data() + p * radix;
+        for (long i = st->b + p * n / st->threads, end = st->b + (p + 1) * n / st->threads; i < end; ++i) {
+            ++h[digit(st->a[i], st->shift)];
+        }
+        if (st->remaining.fetch_sub(1, std::memory_order_acq_rel) != 1) return;
+        // Последняя задача: границы корзин
+        long pos = st->b;
+        for (long i = 0; i < radix; ++i) {
+            st->bucket_start[i] = st->gh[i] = pos;
+            for (long q = 0; q < st->threads; ++q) pos += st->count[q * radix + i];
+            if (pos - st->bucket_start[i] == n) {
+                // Все ключи имеют одинаковый разряд — переходим к следующему без перестановки
+                if (st->shift > 0) msd_radix_job(st->pool, st->a, st->b, st->e - 1, st->state, st->threshold, st->shift - digit_bits);
+                return;
+            }
+        }
+        st->bucket_start[radix] = st->e;
+        start_round(st);
+    });
+}
+
+namespace msd_detail {
+
+// Рекурсия в корзины (маленькие корзины объединяются в одну задачу)
+template <typename T>
+void recurse_buckets(std::shared_ptr<MsdStep<T>> step) {
+    if (step->shift == 0) return;
+    auto run_group = [step](long first, long last) {
+        for (long i = first; i < last; ++i) {
+            long left = step->bucket_start[i], right = step->bucket_start[i + 1] - 1;
+            if (right > left) msd_radix_job(step->pool, step->a, left, right, step->state, step->threshold, step->shift - digit_bits);
+        }
+    };
+    long first = 0, accumulated = 0;
+    for (long i = 0; i < radix; ++i) {
+        accumulated += step->bucket_start[i + 1] - step->bucket_start[i];
+        if (accumulated >= step->threshold || i + 1 == radix) {
+            if (i + 1 == radix) {
+                run_group(first, i + 1);
+            } else {
+                spawn_task_in_pool(step->pool, step->state, [run_group, first, last = i + 1]() { run_group(first, last); });
+            }
+            first = i + 1;
+            accumulated = 0;
+        }
+    }
+}
+
+// Починка: застрявшие чужие элементы корзины меняются на ее элементы из хвоста неразмещенной части
+template <typename T>
+void repair_buckets(std::shared_ptr<MsdStep<T>> step, long p) {
+    for (long i = p * radix / step->threads; i < (p + 1) * radix / step->threads; ++i) {
+        long tail_pos = step->bucket_start[i + 1];
+        bool done = false;
+        for (long q = 0; q < step->threads && !done; ++q) {
+            for (long h = step->head[q * radix + i]; h < step->tail[q * radix + i]; ++h) {
+                while (true) {
+                    if (h >= tail_pos) { done = true; break; }
+                    --tail_pos;
+                    if (digit(step->a[tail_pos], step->shift) == i) {
+                        std::swap(step->a[h], step->a[tail_pos]);
+                        break;
+                    }
+                }
+                if (done) break;
+            }
+        }
+        step->gh[i] = tail_pos;
+    }
+    if (step->remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) start_round(step);
+}
+
+// Перестановка потоком p внутри своих отрезков всех корзин
+template <typename T>
+void permute_thread(std::shared_ptr<MsdStep<T>> step, long p) {
+    permute_parts(step->a, step->head.data() + p * radix, step->tail.data() + p * radix, step->shift);
+    if (step->remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) run_wave(step, repair_buckets<T>);
+}
+
+// Очередной раунд перестановки неразмещенных элементов
+template <typename T>
+void start_round(std::shared_ptr<MsdStep<T>> step) {
+    long unplaced = 0;
+    for (long i = 0; i < radix; ++i) unplaced += step->bucket_start[i + 1] - step->gh[i];
+    if (unplaced == 0) {
+        recurse_buckets(step);
+        return;
+    }
+    step->threads = std::clamp(unplaced / min_part, 1L, long(step->pool.size()));
+    if (unplaced == step->last_unplaced) step->threads = 1; // Раунд ничего не разместил — гарантируем завершение
+    step->last_unplaced = unplaced;
+    step->head.assign(step->threads * radix, 0);
+    step->tail.assign(step->threads * radix, 0);
+    for (long i = 0; i < radix; ++i) {
+        long len = step->bucket_start[i + 1] - step->gh[i];
+        for (long p = 0; p < step->threads; ++p) {
+            step->head[p * radix + i] = step->gh[i] + p * len / step->threads;
+            step->tail[p * radix + i] = step->gh[i] + (p + 1) * len / step->threads;
+        }
+    }
+    if (step->threads == 1) {
+        // Один поток размещает все элементы за один проход
+        permute_parts(step->a, step->head.data(), step->tail.data(), step->shift);
+        recurse_buckets(step);
+        return;
+    }
+    run_wave(step, permute_thread<T>);
+}
+
+} // namespace msd_detail
+
+// Асинхронная MSD-сортировка на месте через пул потоков (тот же интерфейс, что у quicksort_async).
+// Участки не больше opts.leaf_size сортируются сравнением.
+template <typename T>
+std::future<void> msd_radix_sort_async(ThreadPool &pool, T* array, long left, long right, long threshold = 100000,
+                                       const QuicksortOptions &opts = {}) {
+    auto state = std::make_shared<QuicksortState>();
+    state->opts = opts;
+    spawn_task_in_pool(pool, state, [=, &pool]() {
+        if (right > left) msd_radix_job(pool, array, left, right, state, threshold);
+    });
+    return state->prom->get_future();
+}
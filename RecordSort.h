@@ -0,0 +1,174 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include "ThreadPool.h"
+#include "ParallelSort.h"
+#include "SortByKey.h"
+
+
+
+// Сортировка записей в формате gensort (sortbenchmark.org): 100 байт, первые 10 — ключ,
+// ключи сравниваются побайтно как беззнаковые.
+//
+// Записи не двигаются во время сортировки: для каждой строится компактный элемент из 16 байт —
+// первые 8 байт ключа (в порядке big-endian, чтобы сравнение чисел совпадало с побайтным),
+// последние 2 байта ключа и индекс записи. Элементы сортируются на пуле, после чего записи
+// параллельно переставляются по индексам за одно перемещение через буфер. Индекс в младших битах
+// делает сортировку устойчивой.
+//
+// Генератор заполняет записи по раскладке gensort (двоичный режим): ключ, 0x00 0x11, номер строки
+// 32 шестнадцатеричными цифрами, 0x88 0x99 0xAA 0xBB, 48 байт заполнителя, 0xCC 0xDD 0xEE 0xFF.
+// Ключи — из собственного генератора (детерминированного по seed и номеру строки), поэтому файлы
+// совпадают с gensort по формату, но не побайтно. Проверка считает, как valsort, нарушения порядка,
+// повторяющиеся ключи и контрольную сумму — сумму CRC32 записей, не зависящую от их порядка.
+
+constexpr size_t record_size = 100;
+constexpr size_t record_key_size = 10;
+
+// Запись gensort
+struct GensortRecord {
+    unsigned char bytes[record_size];
+};
+
+namespace record_detail {
+
+constexpr long grain = 1L << 14;
+
+// Компактный элемент сортировки: hi — байты ключа 0..7, lo — байты 8..9 и индекс записи
+struct Entry {
+    uint64_t hi;
+    uint64_t lo;
+};
+
+inline bool entry_less(const Entry &a, const Entry &b) {
+    return a.hi < b.hi || (a.hi == b.hi && a.lo < b.lo);
+}
+
+inline Entry make_entry(const GensortRecord &r, long index) {
+    uint64_t hi = 0;
+    for (size_t i = 0; i < 8; ++i) hi = (hi << 8) | r.bytes[i];
+    uint64_t tail = (uint64_t(r.bytes[8]) << 8) | r.bytes[9];
+    return {hi, (tail << 48) | uint64_t(index)};
+}
+
+// CRC32 (полином 0xEDB88320), как в valsort
+inline uint32_t crc32(const unsigned char* data, size_t size) {
+    static const std::array<uint32_t, 256> table = [] {
+        std::array<uint32_t, 256> t {};
+        for (uint32_t i = 0; i < 256; ++i) {
+            uint32_t c = i;
+            for (int k = 0; k < 8; ++k) c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            t[i] = c;
+        }
+        return t;
+    }();
+    uint32_t c = 0xFFFFFFFFu;
+    for (size_t i = 0; i < size; ++i) c = table[(c ^ data[i]) & 0xFF] ^ (c >> 8);
+    return c ^ 0xFFFFFFFFu;
+}
+
+inline uint64_t splitmix64(uint64_t x) {
+    x += 0x9E3779B97F4A7C15ull;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+    return x ^ (x >> 31);
+}
+
+// Запись номер row в раскладке gensort
+inline void fill_record(GensortRecord &r, uint64_t row, uint64_t seed) {
+    static const char hex[] = "0123456789ABCDEF";
+    uint64_t a = splitmix64(seed ^ splitmix64(row));
+    uint64_t b = splitmix64(a);
+    for (size_t i = 0; i < 8; ++i) r.bytes[i] = static_cast<unsigned char>(a >> (56 - 8 * i));
+    r.bytes[8] = static_cast<unsigned char>(b >> 56);
+    r.bytes[9] = static_cast<unsigned char>(b >> 48);
+    r.bytes[10] = 0x00;
+    r.bytes[11] = 0x11;
+    for (size_t i = 0; i < 32; ++i) {
+        r.bytes[12 + i] = i < 16 ? '0' : static_cast<unsigned char>(hex[(row >> (4 * (31 - i))) & 0xF]);
+    }
+    r.bytes[44] = 0x88; r.bytes[45] = 0x99; r.bytes[46] = 0xAA; r.bytes[47] = 0xBB;
+    for (size_t i = 0; i < 12; ++i) {
+        unsigned char c = static_cast<unsigned char>(hex[(b >> (4 * i)) & 0xF]);
+        std::memset(r.bytes + 48 + 4 * i, c, 4);
+    }
+    r.bytes[96] = 0xCC; r.bytes[97] = 0xDD; r.bytes[98] = 0xEE; r.bytes[99] = 0xFF;
+}
+
+} // namespace record_detail
+
+// Сравнение записей по ключу
+inline bool record_key_less(const GensortRecord &a, const GensortRecord &b) {
+    return std::memcmp(a.bytes, b.bytes, record_key_size) < 0;
+}
+
+// Сгенерировать n записей, начиная со строки first_row (результат зависит только от seed и номеров строк).
+// Нельзя вызывать из задачи того же пула
+inline void generate_records(GensortRecord* out, long n, uint64_t first_row, uint64_t seed, ThreadPool &pool) {
+    parallel_for(pool, n, record_detail::grain, [=](long b, long e) {
+        for (long i = b; i < e; ++i) record_detail::fill_record(out[i], first_row + uint64_t(i), seed);
+    });
+}
+
+// Устойчиво отсортировать n записей по ключу. Нельзя вызывать из задачи того же пула
+inline void sort_records(GensortRecord* records, long n, ThreadPool &pool) {
+    using namespace record_detail;
+    if (n < 2) return;
+    std::vector<Entry> entries(n);
+    parallel_for(pool, n, grain, [&](long b, long e) {
+        for (long i = b; i < e; ++i) entries[i] = make_entry(records[i], i);
+    });
+    parallel_sort(entries.begin(), entries.end(), [](const Entry &a, const Entry &b) { return entry_less(a, b); }, pool);
+    const Entry* order = entries.data();
+    constexpr uint64_t index_mask = (uint64_t(1) << 48) - 1;
+    sort_by_key_detail::apply_permutation(records, n, [order](long i) { return long(order[i].lo & index_mask); }, pool);
+}
+
+// Результат проверки файла записей
+struct RecordCheck {
+    long records = 0;
+    long unsorted = 0;    // Пары соседних записей в неправильном порядке
+    long duplicates = 0;  // Пары соседних записей с равными ключами
+    uint64_t checksum = 0; // Сумма CRC32 записей
+    long first_unsorted = -1;
+
+    bool sorted() const { return unsorted == 0; }
+};
+
+// Проверить порядок и посчитать контрольную сумму записей. Нельзя вызывать из задачи того же пула
+inline RecordCheck check_records(const GensortRecord* records, long n, ThreadPool &pool) {
+    using namespace record_detail;
+    RecordCheck result;
+    result.records = n;
+    std::atomic<long> unsorted {0}, duplicates {0}, first_bad {n};
+    std::atomic<uint64_t> checksum {0};
+    parallel_for(pool, n, grain, [&](long b, long e) {
+        long bad = 0, dup = 0;
+        uint64_t sum = 0;
+        for (long i = b; i < e; ++i) {
+            sum += crc32(records[i].bytes, record_size);
+            if (i == 0) continue;
+            int c = std::memcmp(records[i - 1].bytes, records[i].bytes, record_key_size);
+            if (c > 0) {
+                if (bad++ == 0) {
+                    long cur = first_bad.load();
+                    while (i < cur && !first_bad.compare_exchange_weak(cur, i)) {}
+                }
+            } else if (c == 0) {
+                ++dup;
+            }
+        }
+        unsorted += bad;
+        duplicates += dup;
+        checksum += sum;
+    });
+    result.unsorted = unsorted.load();
+    result.duplicates = duplicates.load();
+    result.checksum = checksum.load();
+    if (first_bad.load() < n) result.first_unsorted = first_bad.load();
+    return result;
+}
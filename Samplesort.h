@@ -0,0 +1,435 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+#include "Quicksort.h"
+
+
+
+// Параллельная суперскалярная сортировка выборкой на месте (по мотивам IPS4o).
+//
+// Один шаг распределения участка [b, e) на k корзин выполняется в три фазы, каждая из которых —
+// набор задач пула; последняя завершившаяся задача фазы запускает следующую (без блокировок):
+//  1. Локальная классификация: каждая полоса массива классифицирует свои элементы деревом поиска
+//     без ветвлений и складывает их в буферы корзин; полный буфер (блок) записывается обратно
+//     в начало своей же полосы.
+//  2. Перестановка блоков: блоки переносятся в области своих корзин с помощью атомарных
+//     указателей записи/чтения для каждой корзины.
+//  3. Очистка и рекурсия: неполные буферы и "свесившиеся" части блоков дописываются на границы
+//     корзин, после чего корзины сортируются как отдельные задачи пула.
+// Если выборка содержит повторяющиеся разделители, включаются корзины равных ключей,
+// которые не требуют дальнейшей сортировки. Порядок задается компаратором comp (по умолчанию "<").
+
+namespace samplesort_detail {
+
+constexpr long block_bytes = 1024; // Размер блока распределения в байтах
+constexpr long oversampling = 8;   // Элементов выборки на одну корзину
+constexpr int max_log_leaves = 7;  // Не больше 128 корзин (256 с корзинами равных)
+
+// Дерево поиска по разделителям (раскладка Эйтцингера) для классификации без ветвлений
+template <typename T, typename Compare>
+struct Classifier {
+    std::vector<T> tree;      // Узлы 1..2^L-1
+    std::vector<T> splitters; // Отсортированные уникальные разделители и повтор последнего
+    int log_leaves = 0;
+    long num_splitters = 0;
+    bool equal_buckets = false;
+    long num_buckets = 0;
+    Compare comp;
+
+    explicit Classifier(Compare c) : comp(c) {}
+
+    void build_tree(const std::vector<T>& sorted, size_t node, long lo, long hi) {
+        if (lo > hi) return;
+        long mid = lo + (hi - lo) / 2;
+        tree[node] = sorted[mid];
+        build_tree(sorted, 2 * node, lo, mid - 1);
+        build_tree(sorted, 2 * node + 1, mid + 1, hi);
+    }
+
+    // Номер корзины по рангу j (количество разделителей меньше x)
+    long bucket_of(long j, const T& x) const {
+        j = std::min(j, num_splitters);
+        if (!equal_buckets) return j;
+        const T& s = splitters[j];
+        return 2 * j + long(!comp(x, s) & !comp(s, x));
+    }
+
+    long classify(const T& x) const {
+        size_t i = 1;
+        for (int l = 0; l < log_leaves; ++l) i = 2 * i + size_t(comp(tree[i], x));
+        return bucket_of(long(i) - (long(1) << log_leaves), x);
+    }
+
+    // Классификация группы элементов: обходы дерева чередуются для параллелизма на уровне инструкций
+    void classify_batch(const T* a, long count, long* out) const {
+        constexpr long unroll = 8;
+        long k = 0;
+        for (; k + unroll <= count; k += unroll) {
+            size_t idx[unroll];
+            for (long u = 0; u < unroll; ++u) idx[u] = 1;
+            for (int l = 0; l < log_leaves; ++l) {
+                for (long u = 0; u < unroll; ++u) idx[u] = 2 * idx[u] + size_t(comp(tree[idx[u]], a[k + u]));
+            }
+            for (long u = 0; u < unroll; ++u) out[k + u] = bucket_of(long(idx[u]) - (long(1) << log_leaves), a[k + u]);
+        }
+        for (; k < count; ++k) out[k] = classify(a[k]);
+    }
+};
+
+// Построить классификатор по случайной выборке участка [b, e)
+template <typename T, typename Compare>
+void build_classifier(const T* a, long b, long e, int log_leaves, Classifier<T, Compare>& c) {
+    long n = e - b;
+    long leaves = long(1) << log_leaves;
+    long sample_size = std::min(n, leaves * oversampling);
+    std::vector<T> sample;
+    sample.reserve(sample_size);
+    uint64_t seed = uint64_t(b) * 0x9E3779B97F4A7C15ull + uint64_t(e) + 1;
+    for (long i = 0; i < sample_size; ++i) {
+        sample.push_back(a[b + long(pivot_detail::xorshift64(seed) % uint64_t(n))]);
+    }
+    std::sort(sample.begin(), sample.end(), c.comp);
+
+    std::vector<T> splitters;
+    for (long i = 1; i < leaves; ++i) {
+        const T& s = sample[i * sample_size / leaves];
+        if (splitters.empty() || c.comp(splitters.back(), s)) splitters.push_back(s);
+    }
+    c.log_leaves = log_leaves;
+    c.num_splitters = long(splitters.size());
+    c.equal_buckets = c.num_splitters < leaves - 1;
+    c.num_buckets = c.equal_buckets ? 2 * c.num_splitters + 2 : c.num_splitters + 1;
+    c.splitters = splitters;
+    c.splitters.push_back(splitters.back());
+    while (long(splitters.size()) < leaves - 1) splitters.push_back(splitters.back());
+    c.tree.assign(leaves, splitters[0]);
+    c.build_tree(splitters, 1, 0, leaves - 2);
+}
+
+// Упаковка указателей записи (старшие 32 бита) и чтения + 1 (младшие) одной корзины
+inline int64_t pack(long w, long r1) { return (int64_t(w) << 32) | int64_t(uint32_t(r1)); }
+inline long write_of(int64_t v) { return long(v >> 32); }
+inline long read1_of(int64_t v) { return long(uint32_t(v)); }
+
+// Общее состояние одного шага распределения
+template <typename T, typename Compare>
+struct Step {
+    ThreadPool &pool;
+    std::shared_ptr<QuicksortState> state;
+    T* a;
+    long b, e, threshold;
+    long B = std::max(1L, block_bytes / long(sizeof(T))); // Элементов в блоке
+    long K = 0;                                          // Количество корзин
+    long stripes = 0;
+    Classifier<T, Compare> cls;
+
+    std::vector<long> stripe_block;            // Первый блок каждой полосы (+ граница)
+    std::vector<long> written;                 // Сколько полных блоков записано в начало полосы
+    std::vector<std::vector<T>> buffers;       // Буферы корзин каждой полосы (K * B)
+    std::vector<std::vector<long>> fill;       // Заполненность буферов
+    std::vector<std::vector<long>> blocks;     // Полные блоки каждой корзины по полосам
+    std::atomic<long> remaining {0};           // Незавершенные задачи текущей фазы
+
+    std::vector<long> bucket_start;            // Границы корзин (K + 1 позиция)
+    std::vector<long> bucket_block;            // Первый блок области корзины (выровненная граница)
+    std::vector<char> full;                    // Занят ли блок полным блоком какой-либо корзины
+    std::unique_ptr<std::atomic<int64_t>[]> pointers; // Указатели записи/чтения корзин
+    std::unique_ptr<std::atomic<int>[]> pending;      // Незавершенные чтения блоков корзин
+    std::vector<T> overflow;                   // Блок, выходящий за конец участка
+    long overflow_bucket = -1;                 // Корзина, которой принадлежит этот блок
+    std::vector<std::vector<T>> spill;         // Части блоков, свесившиеся за конец своей корзины
+
+    Step(ThreadPool &p, std::shared_ptr<QuicksortState> s, T* array, long begin, long end, long thr, Compare c)
+        : pool(p), state(std::move(s)), a(array), b(begin), e(end), threshold(thr), cls(c) {}
+
+    T* block_ptr(long q) { return a + b + q * B; }
+
+    // Конец записанных блоков корзины j (за концом участка — только у владельца буфера переполнения)
+    long written_end(long j) const {
+        long end = b + write_of(pointers[j].load()) * B;
+        return j == overflow_bucket ? end : std::min(end, e);
+    }
+};
+
+template <typename T, typename Compare> void local_classification(std::shared_ptr<Step<T, Compare>> step, long stripe);
+template <typename T, typename Compare> void prepare_permutation(std::shared_ptr<Step<T, Compare>> step);
+template <typename T, typename Compare> void compact_buckets(std::shared_ptr<Step<T, Compare>> step, long worker);
+template <typename T, typename Compare> void permute_blocks(std::shared_ptr<Step<T, Compare>> step, long worker);
+template <typename T, typename Compare> void cleanup_and_recurse(std::shared_ptr<Step<T, Compare>> step);
+
+} // namespace samplesort_detail
+
+// Рекурсивная задача сортировки выборкой для пула потоков (маленькие участки — быстрой сортировкой)
+template <typename T, typename Compare = std::less<>>
+void samplesort_job(ThreadPool &pool, T* array, long left, long right, std::shared_ptr<QuicksortState> state, long threshold,
+                    Compare comp = {}) {
+    using namespace samplesort_detail;
+    long n = right - left + 1;
+    long B = std::max(1L, block_bytes / long(sizeof(T)));
+    if (n <= threshold || n < 64 * B) {
+        quicksort_job(pool, array, left, right, state, threshold, comp);
+        return;
+    }
+    int log_leaves = 1;
+    while (log_leaves < max_log_leaves && (long(2) << log_leaves) * B * 8 <= n) ++log_leaves;
+
+    auto step = std::make_shared<Step<T, Compare>>(pool, state, array, left, right + 1, threshold, comp);
+    build_classifier(array, left, right + 1, log_leaves, step->cls);
+    step->K = step->cls.num_buckets;
+    long full_blocks = n / step->B;
+    step->stripes = std::clamp(n / (4 * step->K * step->B), 1L, long(pool.size()));
+    step->stripe_block.resize(step->stripes + 1);
+    for (long i = 0; i <= step->stripes; ++i) step->stripe_block[i] = i * full_blocks / step->stripes;
+    step->written.assign(step->stripes, 0);
+    step->buffers.resize(step->stripes);
+    step->fill.assign(step->stripes, std::vector<long>(step->K, 0));
+    step->blocks.assign(step->stripes, std::vector<long>(step->K, 0));
+
+    step->remaining.store(step->stripes);
+    for (long i = 1; i < step->stripes; ++i) {
+        spawn_task_in_pool(pool, state, [step, i]() { local_classification(step, i); });
+    }
+    local_classification(step, 0);
+}
+
+namespace samplesort_detail {
+
+// Фаза 1: классификация полосы с записью полных блоков в начало полосы
+template <typename T, typename Compare>
+void local_classification(std::shared_ptr<Step<T, Compare>> step, long stripe) {
+    T* a = step->a;
+    long B = step->B;
+    long from = step->b + step->stripe_block[stripe] * B;
+    long to = stripe + 1 == step->stripes ? step->e : step->b + step->stripe_block[stripe + 1] * B;
+    std::vector<T> &buf = step->buffers[stripe];
+    buf.resize(step->K * B);
+    long* fill = step->fill[stripe].data();
+    long* blocks = step->blocks[stripe].data();
+    long write = from;
+
+    constexpr long batch = 64;
+    long ids[batch];
+    for (long pos = from; pos < to; pos += batch) {
+        long count = std::min(batch, to - pos);
+        step->cls.classify_batch(a + pos, count, ids);
+        for (long u = 0; u < count; ++u) {
+            long j = ids[u];
+            T* bucket_buf = buf.data() + j * B;
+            bucket_buf[fill[j]++] = std::move(a[pos + u]);
+            if (fill[j] == B) {
+                // Прочитано не меньше, чем записано, поэтому блок не затирает непрочитанные элементы
+                std::move(bucket_buf, bucket_buf + B, a + write);
+                write += B;
+                fill[j] = 0;
+                ++blocks[j];
+            }
+        }
+    }
+    step->written[stripe] = (write - from) / B;
+    if (step->remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) prepare_permutation(step);
+}
+
+// Между фазами 1 и 2: границы корзин и отметки полных блоков; затем волна сдвига блоков
+template <typename T, typename Compare>
+void prepare_permutation(std::shared_ptr<Step<T, Compare>> step) {
+    long K = step->K, B = step->B, n = step->e - step->b;
+    long num_blocks = (n + B - 1) / B;
+
+    step->bucket_start.assign(K + 1, step->b);
+    step->bucket_block.assign(K + 1, 0);
+    long pos = 0;
+    for (long j = 0; j < K; ++j) {
+        step->bucket_start[j] = step->b + pos;
+        step->bucket_block[j] = (pos + B - 1) / B;
+        for (long i = 0; i < step->stripes; ++i) pos += step->blocks[i][j] * B + step->fill[i][j];
+    }
+    step->bucket_start[K] = step->e;
+    step->bucket_block[K] = num_blocks;
+
+    step->full.assign(num_blocks, 0);
+    for (long i = 0; i < step->stripes; ++i) {
+        for (long q = 0; q < step->written[i]; ++q) step->full[step->stripe_block[i] + q] = 1;
+    }
+
+    step->pointers.reset(new std::atomic<int64_t>[K]);
+    step->pending.reset(new std::atomic<int>[K]);
+
+    long workers = step->stripes;
+    step->remaining.store(workers);
+    for (long i = 1; i < workers; ++i) {
+        spawn_task_in_pool(step->pool, step->state, [step, i]() { compact_buckets(step, i); });
+    }
+    compact_buckets(step, 0);
+}
+
+// Сдвиг полных блоков в начало областей своих корзин; области корзин не пересекаются,
+// поэтому корзины делятся между задачами. Последняя задача запускает перестановку
+template <typename T, typename Compare>
+void compact_buckets(std::shared_ptr<Step<T, Compare>> step, long worker) {
+    long K = step->K, B = step->B;
+    std::vector<char> &full = step->full;
+    for (long j = worker * K / step->stripes, last = (worker + 1) * K / step->stripes; j < last; ++j) {
+        // Таких перемещений мало: пустые блоки остаются только в хвостах полос
+        long lo = step->bucket_block[j], hi = step->bucket_block[j + 1] - 1;
+        while (true) {
+            while (lo < hi && full[lo]) ++lo;
+            while (hi > lo && !full[hi]) --hi;
+            if (lo >= hi) break;
+            std::move(step->block_ptr(hi), step->block_ptr(hi) + B, step->block_ptr(lo));
+            full[lo] = 1;
+            full[hi] = 0;
+        }
+        long full_count = 0;
+        for (long q = step->bucket_block[j]; q < step->bucket_block[j + 1] && full[q]; ++q) ++full_count;
+        step->pointers[j].store(pack(step->bucket_block[j], step->bucket_block[j] + full_count));
+        step->pending[j].store(0);
+    }
+    if (step->remaining.fetch_sub(1, std::memory_order_acq_rel) != 1) return;
+
+    long workers = step->stripes;
+    step->remaining.store(workers);
+    for (long i = 1; i < workers; ++i) {
+        spawn_task_in_pool(step->pool, step->state, [step, i]() { permute_blocks(step, i); });
+    }
+    permute_blocks(step, 0);
+}
+
+// Фаза 2: перестановка блоков по корзинам
+template <typename T, typename Compare>
+void permute_blocks(std::shared_ptr<Step<T, Compare>> step, long worker) {
+    long K = step->K, B = step->B;
+    std::vector<T> swap_buf(2 * B);
+    T* current = swap_buf.data();
+    T* other = swap_buf.data() + B;
+
+    long first_bucket = worker * K / step->stripes;
+    for (long probe = 0; probe < K;) {
+        long j = (first_bucket + probe) % K;
+        // Забираем необработанный блок с конца области корзины j
+        step->pending[j].fetch_add(1);
+        int64_t v = step->pointers[j].load();
+        long taken = -1;
+        while (write_of(v) < read1_of(v)) {
+            if (step->pointers[j].compare_exchange_weak(v, pack(write_of(v), read1_of(v) - 1))) {
+                taken = read1_of(v) - 1;
+                break;
+            }
+        }
+        if (taken < 0) {
+            if (step->pending[j].fetch_sub(1) == 1) step->pending[j].notify_all();
+            ++probe;
+            continue;
+        }
+        std::move(step->block_ptr(taken), step->block_ptr(taken) + B, current);
+        if (step->pending[j].fetch_sub(1) == 1) step->pending[j].notify_all();
+
+        // Переносим блок в его корзину; если там лежит необработанный блок — меняемся с ним
+        while (true) {
+            long dest = step->cls.classify(current[0]);
+            int64_t old = step->pointers[dest].fetch_add(int64_t(1) << 32);
+            long slot = write_of(old);
+            T* target = step->block_ptr(slot);
+            if (slot < read1_of(old)) {
+                std::move(target, target + B, other);
+                std::move(current, current + B, target);
+                std::swap(current, other);
+                continue;
+            }
+            if (step->b + (slot + 1) * B > step->e) {
+                // Последний блок выходит за конец участка — откладываем в отдельный буфер
+                step->overflow.assign(std::make_move_iterator(current), std::make_move_iterator(current + B));
+                step->overflow_bucket = dest;
+            } else {
+                // Дожидаемся окончания чтений из этой корзины: слот мог только что освободиться.
+                // Поток засыпает на счетчике, а не крутится, занимая ядро у задач других заданий
+                for (int p = step->pending[dest].load(); p != 0; p = step->pending[dest].load()) step->pending[dest].wait(p);
+                std::move(current, current + B, target);
+            }
+            break;
+        }
+    }
+    if (step->remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) cleanup_and_recurse(step);
+}
+
+// Заполнить свободные места корзины j остатками из буферов и сохраненными "свесами"
+template <typename T, typename Compare>
+void cleanup_bucket(Step<T, Compare> &step, long j) {
+    long B = step.B;
+    long start = step.bucket_start[j], end = step.bucket_start[j + 1];
+    long region = step.b + step.bucket_block[j] * B;
+    long written_end = step.written_end(j);
+    long head_end = std::min(region, end);
+    long pos = start;
+    auto put = [&](T &x) {
+        if (pos == head_end) pos = std::max(pos, written_end);
+        step.a[pos++] = std::move(x);
+    };
+    for (T &x : step.spill[j]) put(x);
+    for (long i = 0; i < step.stripes; ++i) {
+        T* buf = step.buffers[i].data() + j * B;
+        for (long k = 0; k < step.fill[i][j]; ++k) put(buf[k]);
+    }
+}
+
+// Фаза 3: сохранение "свесов", дописывание буферов и рекурсивная сортировка корзин
+template <typename T, typename Compare>
+void cleanup_and_recurse(std::shared_ptr<Step<T, Compare>> step) {
+    long K = step->K, B = step->B;
+    step->spill.assign(K, {});
+    for (long j = 0; j < K; ++j) {
+        long end = step->bucket_start[j + 1];
+        long written_end = step->written_end(j);
+        if (j == step->overflow_bucket) {
+            // Блок из буфера переполнения: начало ложится в хвост массива, остальное — "свес"
+            long block_begin = written_end - B;
+            std::move(step->overflow.begin(), step->overflow.begin() + (step->e - block_begin), step->a + block_begin);
+        }
+        long region = step->b + step->bucket_block[j] * B;
+        for (long p = std::max(end, region); p < written_end; ++p) {
+            step->spill[j].push_back(std::move(p < step->e ? step->a[p] : step->overflow[p - (written_end - B)]));
+        }
+    }
+
+    // Корзины группируются в задачи так, чтобы маленькие не порождали отдельную задачу каждая
+    auto run_group = [step](long first, long last) {
+        for (long j = first; j < last; ++j) {
+            cleanup_bucket(*step, j);
+            long left = step->bucket_start[j], right = step->bucket_start[j + 1] - 1;
+            bool equal_bucket = step->cls.equal_buckets && (j % 2 == 1);
+            if (right - left < 1 || equal_bucket) continue;
+            samplesort_job(step->pool, step->a, left, right, step->state, step->threshold, step->cls.comp);
+        }
+    };
+    long first = 0, accumulated = 0;
+    for (long j = 0; j < K; ++j) {
+        accumulated += step->bucket_start[j + 1] - step->bucket_start[j];
+        if (accumulated >= step->threshold || j + 1 == K) {
+            long last = j + 1;
+            if (last == K) {
+                run_group(first, last);
+            } else {
+                spawn_task_in_pool(step->pool, step->state, [run_group, first, last]() { run_group(first, last); });
+            }
+            first = last;
+            accumulated = 0;
+        }
+    }
+}
+
+} // namespace samplesort_detail
+
+// Асинхронный запуск сортировки выборкой через пул потоков (тот же интерфейс, что у quicksort_async)
+template <typename T, typename Compare = std::less<>>
+std::future<void> samplesort_async(ThreadPool &pool, T* array, long left, long right, long threshold = 100000,
+                                   const QuicksortOptions &opts = {}, Compare comp = {}) {
+    auto state = std::make_shared<QuicksortState>();
+    state->opts = opts;
+    spawn_task_in_pool(pool, state, [=, &pool]() {
+        samplesort_job(pool, array, left, right, state, threshold, comp);
+    });
+    return state->prom->get_future();
+}
@@ -0,0 +1,86 @@
+#pragma once
+#include <algorithm>
+#include <functional>
+#include <future>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+#include "ThreadPool.h"
+#include "Quicksort.h"
+
+
+
+// Сортировка множества независимых участков одного буфера за один вызов.
+//
+// Участок i — это [offsets[i], offsets[i + 1]). На весь вызов приходится одно состояние, один
+// promise и одна корневая задача. Корневая задача проходит по участкам и собирает маленькие в
+// пачки примерно по batch_elements элементов: каждая пачка — одна задача пула, сортирующая свои
+// участки подряд. Участки больше порога получают собственную задачу быстрой сортировки, которая
+// делится дальше как обычно.
+
+namespace segmented_detail {
+
+constexpr long batch_elements = 1L << 16; // Элементов в пачке маленьких участков
+
+template <typename RandomIt, typename Compare>
+void sort_batch(ThreadPool &pool, RandomIt data, const std::vector<long> &offsets, long first, long last,
+                const std::shared_ptr<QuicksortState> &state, long threshold, Compare comp) {
+    for (long i = first; i < last; ++i) {
+        quicksort_job(pool, data, offsets[i], offsets[i + 1] - 1, state, threshold, comp);
+    }
+}
+
+} // namespace segmented_detail
+
+// Асинхронно отсортировать каждый участок [offsets[i], offsets[i + 1]) буфера data.
+// offsets не убывают; при нарушении — std::invalid_argument до запуска задач
+template <typename RandomIt, typename Compare = std::less<>>
+std::future<void> segmented_sort_async(ThreadPool &pool, RandomIt data, std::vector<long> offsets, long threshold = 100000,
+                                       const QuicksortOptions &opts = {}, Compare comp = {}) {
+    using namespace segmented_detail;
+    if (!offsets.empty() && offsets.front() < 0) throw std::invalid_argument("сортировка участков: отрицательное смещение");
+    if (std::is_sorted_until(offsets.begin(), offsets.end()) != offsets.end()) {
+        throw std::invalid_argument("сортировка участков: смещения должны не убывать");
+    }
+    auto state = std::make_shared<QuicksortState>();
+    state->opts = opts;
+    auto segs = std::make_shared<const std::vector<long>>(std::move(offsets));
+    spawn_task_in_pool(pool, state, [=, &pool]() {
+        const std::vector<long> &off = *segs;
+        long k = long(off.size()) - 1;
+        long batch_begin = 0, batch_size = 0;
+        auto flush = [&](long end) {
+            if (batch_begin < end) {
+                long b = batch_begin;
+                spawn_task_in_pool(pool, state, [=, &pool]() { sort_batch(pool, data, *segs, b, end, state, threshold, comp); });
+            }
+            batch_begin = end;
+            batch_size = 0;
+        };
+        for (long i = 0; i < k; ++i) {
+            long len = off[i + 1] - off[i];
+            if (len > threshold) {
+                // Большой участок — своя задача, внутри делится быстрой сортировкой
+                flush(i);
+                spawn_task_in_pool(pool, state, [=, &pool]() {
+                    quicksort_job(pool, data, (*segs)[i], (*segs)[i + 1] - 1, state, threshold, comp);
+                });
+                batch_begin = i + 1;
+                continue;
+            }
+            batch_size += len;
+            if (batch_size >= batch_elements) flush(i + 1);
+        }
+        // Последняя пачка — в корневой задаче
+        sort_batch(pool, data, off, batch_begin, std::max(k, batch_begin), state, threshold, comp);
+    });
+    return state->prom->get_future();
+}
+
+// Отсортировать каждый участок [offsets[i], offsets[i + 1]) буфера data. Нельзя вызывать из задачи того же пула
+template <typename RandomIt, typename Compare = std::less<>>
+void segmented_sort(RandomIt data, std::vector<long> offsets, ThreadPool &pool, Compare comp = {}, long threshold = 100000) {
+    QuicksortOptions opts;
+    opts.kernel = PartitionKernel::Simd;
+    segmented_sort_async(pool, data, std::move(offsets), threshold, opts, comp).get();
+}
@@ -0,0 +1,261 @@
+#pragma once
+#include <algorithm>
+#include <bit>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <vector>
+#include "ThreadPool.h"
+#include "Quicksort.h"
+#include "ParallelSort.h"
+
+
+
+// Частичная сортировка и выбор порядковой статистики на пуле потоков.
+//
+// nth_element — быстрый выбор: после каждого разбиения продолжается только часть, содержащая
+// нужную позицию. Пока участок больше порога, разбиение на три части (<, ==, > опорного) делят
+// задачи пула: подсчет по частям массива, префиксные суммы, раскладка в буфер и копирование
+// обратно. Меньшие участки разбиваются последовательно теми же шагами, что и в быстрой
+// сортировке (включая блочное и векторное ядра). partial_sort разбивает участок так же, но часть, которая целиком нужна
+// в отсортированном виде, отдается quicksort_job (большие — отдельной задачей пула), а рекурсия
+// продолжается только в часть, пересекающую границу. top_k не меняет вход: каждая часть массива
+// отбирает свои k лучших элементов в куче, затем кандидаты упорядочиваются.
+
+namespace selection_detail {
+
+// Быстрый выбор на участке [left, right]: на позиции nth окажется элемент, стоящий там после сортировки.
+// Если разбиения вырождаются, остаток выбирается std::nth_element (гарантированная сложность)
+template <typename RandomIt, typename Compare>
+void select_range(RandomIt array, long left, long right, long nth, const QuicksortOptions &opts, long sample_cutoff,
+                  Compare comp) {
+    int budget = 2 * std::bit_width(static_cast<unsigned long>(right - left + 1));
+    while (right - left >= opts.leaf_size && budget-- > 0) {
+        auto [r, l] = partition_step(array, left, right, opts, sample_cutoff, comp);
+        if (nth <= r) right = r;
+        else if (nth >= l) left = l;
+        else return; // Позиция попала в отрезок, равный опорному элементу
+    }
+    if (left < right) std::nth_element(array + left, array + nth, array + right + 1, comp);
+}
+
+constexpr long min_chunk = 1L << 16; // Минимальная часть массива на задачу параллельного разбиения
+
+// Состояние параллельного выбора: текущий участок [left, right] и волны одного разбиения
+template <typename RandomIt, typename Compare>
+struct SelectState {
+    using T = typename std::iterator_traits<RandomIt>::value_type;
+
+    ThreadPool &pool;
+    std::shared_ptr<QuicksortState> state;
+    RandomIt array;
+    long left, right, nth, threshold;
+    Compare comp;
+    int budget;                // Разбиений до перехода к последовательному выбору
+    long chunks = 1;
+    std::optional<T> pivot;
+    std::vector<long> counts;  // chunks * 3: число <, == и > в части, затем их позиции в буфере
+    std::vector<T> buf;        // Буфер раскладки (индексируется от left)
+    std::atomic<long> remaining {0};
+
+    SelectState(ThreadPool &p, std::shared_ptr<QuicksortState> s, RandomIt a, long lo, long hi, long k, long thr, Compare c)
+        : pool(p), state(std::move(s)), array(a), left(lo), right(hi), nth(k), threshold(thr), comp(c),
+          budget(2 * std::bit_width(static_cast<unsigned long>(hi - lo + 1))) {}
+
+    long size() const { return right - left + 1; }
+    long chunk_begin(long c) const { return left + c * size() / chunks; }
+};
+
+template <typename S> void select_step(std::shared_ptr<S> st);
+
+template <typename S, typename Fn>
+void run_wave(std::shared_ptr<S> st, Fn fn) {
+    st->remaining.store(st->chunks);
+    for (long c = 1; c < st->chunks; ++c) {
+        spawn_task_in_pool(st->pool, st->state, [st, c, fn]() { fn(st, c); });
+    }
+    fn(st, 0);
+}
+
+template <typename S>
+bool last_of_wave(const std::shared_ptr<S> &st) {
+    return st->remaining.fetch_sub(1, std::memory_order_acq_rel) == 1;
+}
+
+// Перенос части c обратно из буфера; последняя задача сужает участок до части с позицией nth
+template <typename S>
+void copy_back_chunk(std::shared_ptr<S> st, long c) {
+    long b = st->chunk_begin(c), e = st->chunk_begin(c + 1);
+    std::move(st->buf.begin() + (b - st->left), st->buf.begin() + (e - st->left), st->array + b);
+    if (!last_of_wave(st)) return;
+    // counts хранят позиции: начало "==" первой части — конец всех "<", начало ">" — конец всех "=="
+    long less = st->counts[1] - st->left;
+    long equal = st->counts[2] - st->counts[1];
+    if (st->nth < st->left + less) {
+        st->right = st->left + less - 1;
+    } else if (st->nth >= st->left + less + equal) {
+        st->left += less + equal;
+    } else {
+        return; // Позиция попала в отрезок, равный опорному элементу
+    }
+    select_step(st);
+}
+
+// Раскладка части c в буфер по трем классам
+template <typename S>
+void scatter_chunk(std::shared_ptr<S> st, long c) {
+    auto &comp = st->comp;
+    const auto &pivot = *st->pivot;
+    long pos[3] = {st->counts[3 * c] - st->left, st->counts[3 * c + 1] - st->left, st->counts[3 * c + 2] - st->left};
+    for (long i = st->chunk_begin(c), e = st->chunk_begin(c + 1); i < e; ++i) {
+        int cls = comp(st->array[i], pivot) ? 0 : comp(pivot, st->array[i]) ? 2 : 1;
+        st->buf[pos[cls]++] = std::move(st->array[i]);
+    }
+    if (last_of_wave(st)) run_wave(st, copy_back_chunk<S>);
+}
+
+// Подсчет классов в части c; последняя задача переводит счетчики в позиции
+template <typename S>
+void count_chunk(std::shared_ptr<S> st, long c) {
+    auto &comp = st->comp;
+    const auto &pivot = *st->pivot;
+    long cnt[3] = {0, 0, 0};
+    for (long i = st->chunk_begin(c), e = st->chunk_begin(c + 1); i < e; ++i) {
+        ++cnt[comp(st->array[i], pivot) ? 0 : comp(pivot, st->array[i]) ? 2 : 1];
+    }
+    std::copy(cnt, cnt + 3, st->counts.begin() + 3 * c);
+    if (!last_of_wave(st)) return;
+    long pos = st->left;
+    for (int cls = 0; cls < 3; ++cls) {
+        for (long q = 0; q < st->chunks; ++q) {
+            long n = st->counts[3 * q + cls];
+            st->counts[3 * q + cls] = pos;
+            pos += n;
+        }
+    }
+    run_wave(st, scatter_chunk<S>);
+}
+
+// Очередное разбиение участка: параллельное, пока участок больше порога, затем последовательный выбор
+template <typename S>
+void select_step(std::shared_ptr<S> st) {
+    const QuicksortOptions &opts = st->state->opts;
+    long n = st->size();
+    st->chunks = std::clamp(n / min_chunk, 1L, long(st->pool.size()));
+    if (n <= st->threshold || st->chunks == 1 || st->budget-- <= 0) {
+        select_range(st->array, st->left, st->right, st->nth, opts, st->threshold, st->comp);
+        return;
+    }
+    st->pivot = select_pivot(st->array, st->left, st->right, opts.pivot, st->threshold, st->comp);
+    st->counts.assign(3 * st->chunks, 0);
+    if (st->buf.empty()) st->buf.resize(n); // Участок только сужается: буфера первого шага хватает до конца
+    run_wave(st, count_chunk<S>);
+}
+
+} // namespace selection_detail
+
+// Задача выбора: на позиции nth участка [left, right] окажется элемент, стоящий там после сортировки
+template <typename RandomIt, typename Compare = std::less<>>
+void nth_element_job(ThreadPool &pool, RandomIt array, long left, long right, long nth,
+                     std::shared_ptr<QuicksortState> state, long threshold, Compare comp = {}) {
+    using namespace selection_detail;
+    if (nth < left || nth > right || left >= right) return;
+    using S = SelectState<RandomIt, Compare>;
+    select_step(std::make_shared<S>(pool, std::move(state), array, left, right, nth, threshold, comp));
+}
+
+// Задача частичной сортировки: упорядочить [left, middle) наименьшими элементами участка [left, right]
+template <typename RandomIt, typename Compare = std::less<>>
+void partial_sort_job(ThreadPool &pool, RandomIt array, long left, long right, long middle,
+                      std::shared_ptr<QuicksortState> state, long threshold, Compare comp = {}) {
+    if (left >= right || middle <= left) return;
+    if (middle > right) {
+        quicksort_job(pool, array, left, right, state, threshold, comp); // Нужен весь участок
+        return;
+    }
+    if (right - left < state->opts.leaf_size) {
+        std::partial_sort(array + left, array + middle, array + right + 1, comp);
+        return;
+    }
+
+    auto [r, l] = partition_step(array, left, right, state->opts, threshold, comp);
+    // Левая часть нужна всегда (целиком или до middle), правая — только если middle заходит в нее
+    if (r - left > threshold && middle > l) {
+        spawn_task_in_pool(pool, state, [=, &pool]() {
+            partial_sort_job(pool, array, left, r, middle, state, threshold, comp);
+        });
+    } else {
+        partial_sort_job(pool, array, left, r, middle, state, threshold, comp);
+    }
+    partial_sort_job(pool, array, l, right, middle, state, threshold, comp);
+}
+
+// Асинхронный выбор: на позиции nth участка [left, right] окажется элемент, стоящий там после
+// сортировки, левее — не большие, правее — не меньшие
+template <typename RandomIt, typename Compare = std::less<>>
+std::future<void> nth_element_async(ThreadPool &pool, RandomIt array, long left, long right, long nth,
+                                    long threshold = 100000, const QuicksortOptions &opts = {}, Compare comp = {}) {
+    auto state = std::make_shared<QuicksortState>();
+    state->opts = opts;
+    spawn_task_in_pool(pool, state, [=, &pool]() {
+        nth_element_job(pool, array, left, right, nth, state, threshold, comp);
+    });
+    return state->prom->get_future();
+}
+
+// Асинхронная частичная сортировка: [left, middle) — наименьшие элементы участка [left, right]
+// в отсортированном порядке, остальные — в произвольном
+template <typename RandomIt, typename Compare = std::less<>>
+std::future<void> partial_sort_async(ThreadPool &pool, RandomIt array, long left, long right, long middle,
+                                     long threshold = 100000, const QuicksortOptions &opts = {}, Compare comp = {}) {
+    auto state = std::make_shared<QuicksortState>();
+    state->opts = opts;
+    spawn_task_in_pool(pool, state, [=, &pool]() {
+        partial_sort_job(pool, array, left, right, middle, state, threshold, comp);
+    });
+    return state->prom->get_future();
+}
+
+// k наименьших (в смысле comp) элементов [first, last) в отсортированном порядке; вход не меняется.
+// Нельзя вызывать из задачи того же пула
+template <typename RandomIt, typename Compare = std::less<>>
+std::vector<typename std::iterator_traits<RandomIt>::value_type>
+top_k(RandomIt first, RandomIt last, long k, ThreadPool &pool, Compare comp = {}) {
+    using T = typename std::iterator_traits<RandomIt>::value_type;
+    long n = long(last - first);
+    k = std::clamp(k, 0L, n);
+    std::vector<T> result;
+    if (k == 0) return result;
+
+    if (k > n / 8) {
+        // Большая доля массива: копия и частичная сортировка
+        result.assign(first, last);
+        partial_sort_async(pool, result.data(), 0, n - 1, k, 100000, {}, comp).get();
+        result.erase(result.begin() + k, result.end());
+        return result;
+    }
+
+    // Каждая часть держит кучу из k лучших с худшим из них в вершине
+    std::mutex mtx;
+    parallel_for(pool, n, std::max(1L << 16, 4 * k), [&](long b, long e) {
+        std::vector<T> heap;
+        heap.reserve(k);
+        for (long i = b; i < e; ++i) {
+            if (long(heap.size()) < k) {
+                heap.push_back(first[i]);
+                std::push_heap(heap.begin(), heap.end(), comp);
+            } else if (comp(first[i], heap.front())) {
+                std::pop_heap(heap.begin(), heap.end(), comp);
+                heap.back() = first[i];
+                std::push_heap(heap.begin(), heap.end(), comp);
+            }
+        }
+        std::lock_guard<std::mutex> lock(mtx);
+        result.insert(result.end(), std::make_move_iterator(heap.begin()), std::make_move_iterator(heap.end()));
+    });
+    std::partial_sort(result.begin(), result.begin() + k, result.end(), comp);
+    result.erase(result.begin() + k, result.end());
+    return result;
+}
@@ -0,0 +1,165 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include "Partition.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define SIMD_PARTITION_X86 1
+#include <immintrin.h>
+#endif
+
+
+
+// Векторное разбиение массива int по значению pivot (AVX2 / AVX-512).
+// Реализация выбирается один раз во время выполнения по CPUID; если векторные инструкции
+// недоступны, используется скалярное блочное разбиение, поэтому один бинарник работает везде.
+//
+// Схема разбиения (как в работах Bramas, vxsort): первые и последние векторы участка сохраняются
+// в регистрах, освобождая место на обоих краях; затем очередной вектор читается с той стороны,
+// где свободного места меньше, сравнивается с pivot и сжатой записью (compress-store) раскладывается
+// влево и вправо. Хвост и сохраненные векторы дописываются скалярно.
+
+namespace simd_partition_detail {
+
+// Скалярная раскладка элементов из временного буфера в свободную область [write_l, write_r)
+inline void scatter_rest(int* array, long &write_l, long &write_r, const int* buf, long count, int pivot, bool or_equal) {
+    for (long k = 0; k < count; ++k) {
+        int x = buf[k];
+        bool to_left = or_equal ? !(pivot < x) : x < pivot;
+        if (to_left) array[write_l++] = x;
+        else array[--write_r] = x;
+    }
+}
+
+#ifdef SIMD_PARTITION_X86
+
+// Таблица перестановок для AVX2: для маски "левых" элементов сначала идут левые полосы, затем правые
+inline constexpr auto avx2_permutations = [] {
+    std::array<std::array<int, 8>, 256> table {};
+    for (int mask = 0; mask < 256; ++mask) {
+        int pos = 0;
+        for (int lane = 0; lane < 8; ++lane) if (mask & (1 << lane)) table[mask][pos++] = lane;
+        for (int lane = 0; lane < 8; ++lane) if (!(mask & (1 << lane))) table[mask][pos++] = lane;
+    }
+    return table;
+}();
+
+// Разбиение [b, e) на AVX2; возвращает границу: [b, m) — левая часть, [m, e) — правая.
+// or_equal == false: слева x < pivot; or_equal == true: слева x <= pivot
+__attribute__((target("avx2")))
+inline long partition_avx2(int* array, long b, long e, int pivot, bool or_equal) {
+    constexpr long W = 8;
+    const __m256i vp = _mm256_set1_epi32(pivot);
+    int saved[3 * W];
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(saved), _mm256_loadu_si256(reinterpret_cast<const __m256i*>(array + b)));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(saved + W), _mm256_loadu_si256(reinterpret_cast<const __m256i*>(array + e - W)));
+    long read_l = b + W, read_r = e - W;
+    long write_l = b, write_r = e;
+
+    while (read_r - read_l >= W) {
+        __m256i v;
+        if (read_l - write_l <= write_r - read_r) {
+            v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(array + read_l));
+            read_l += W;
+        } else {
+            read_r -= W;
+            v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(array + read_r));
+        }
+        __m256i right_mask = or_equal ? _mm256_cmpgt_epi32(v, vp)
+                                      : _mm256_xor_si256(_mm256_cmpgt_epi32(vp, v), _mm256_set1_epi32(-1));
+        int mask = ~_mm256_movemask_ps(_mm256_castsi256_ps(right_mask)) & 0xFF; // Маска левых полос
+        __m256i idx = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(avx2_permutations[mask].data()));
+        __m256i packed = _mm256_permutevar8x32_epi32(v, idx);
+        long count_l = __builtin_popcount(mask);
+        // Полная запись вектора безопасна: с обеих сторон свободно не меньше W элементов
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(array + write_l), packed);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(array + write_r - W), packed);
+        write_l += count_l;
+        write_r -= W - count_l;
+    }
+
+    long tail = read_r - read_l;
+    for (long k = 0; k < tail; ++k) saved[2 * W + k] = array[read_l + k];
+    scatter_rest(array, write_l, write_r, saved, 2 * W + tail, pivot, or_equal);
+    return write_l;
+}
+
+// Разбиение [b, e) на AVX-512 со сжатой записью; семантика как у partition_avx2
+__attribute__((target("avx512f")))
+inline long partition_avx512(int* array, long b, long e, int pivot, bool or_equal) {
+    constexpr long W = 16;
+    const __m512i vp = _mm512_set1_epi32(pivot);
+    int saved[3 * W];
+    _mm512_storeu_si512(saved, _mm512_loadu_si512(array + b));
+    _mm512_storeu_si512(saved + W, _mm512_loadu_si512(array + e - W));
+    long read_l = b + W, read_r = e - W;
+    long write_l = b, write_r = e;
+
+    while (read_r - read_l >= W) {
+        __m512i v;
+        if (read_l - write_l <= write_r - read_r) {
+            v = _mm512_loadu_si512(array + read_l);
+            read_l += W;
+        } else {
+            read_r -= W;
+            v = _mm512_loadu_si512(array + read_r);
+        }
+        __mmask16 left = or_equal ? _mm512_cmple_epi32_mask(v, vp) : _mm512_cmplt_epi32_mask(v, vp);
+        long count_l = __builtin_popcount(left);
+        _mm512_mask_compressstoreu_epi32(array + write_l, left, v);
+        _mm512_mask_compressstoreu_epi32(array + write_r - (W - count_l), static_cast<__mmask16>(~left), v);
+        write_l += count_l;
+        write_r -= W - count_l;
+    }
+
+    long tail = read_r - read_l;
+    for (long k = 0; k < tail; ++k) saved[2 * W + k] = array[read_l + k];
+    scatter_rest(array, write_l, write_r, saved, 2 * W + tail, pivot, or_equal);
+    return write_l;
+}
+
+#endif
+
+using partition_fn = long (*)(int*, long, long, int, bool);
+
+// Выбор реализации по возможностям процессора (выполняется один раз)
+inline partition_fn choose_partition() {
+#ifdef SIMD_PARTITION_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) return partition_avx512;
+    if (__builtin_cpu_supports("avx2")) return partition_avx2;
+#endif
+    return nullptr;
+}
+
+inline partition_fn selected_partition() {
+    static const partition_fn fn = choose_partition();
+    return fn;
+}
+
+} // namespace simd_partition_detail
+
+// Название выбранной реализации векторного разбиения (для вывода в демонстрации)
+inline const char* simd_partition_isa() {
+    using namespace simd_partition_detail;
+#ifdef SIMD_PARTITION_X86
+    partition_fn fn = selected_partition();
+    if (fn == partition_avx512) return "AVX-512";
+    if (fn == partition_avx2) return "AVX2";
+#endif
+    return "scalar";
+}
+
+// Векторное разбиение участка [left, right] массива int (pivot должен присутствовать в участке).
+// Слева оказываются элементы < pivot, справа — >= pivot. Если левая часть пуста (pivot — минимум),
+// выполняется второй проход по условию <= pivot: все равные pivot элементы уходят в середину
+// и больше не участвуют в рекурсии.
+inline PartitionResult partition_simd(int* array, long left, long right, int pivot) {
+    using namespace simd_partition_detail;
+    partition_fn fn = selected_partition();
+    if (!fn || right - left + 1 < 64) return partition_block(array, left, right, pivot);
+    long m = fn(array, left, right + 1, pivot, false);
+    if (m > left) return {m - 1, m};
+    m = fn(array, left, right + 1, pivot, true);
+    return {left - 1, m};
+}
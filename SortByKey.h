@@ -0,0 +1,152 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <ranges>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "ThreadPool.h"
+#include "ParallelSort.h"
+#include "RadixSort.h"
+
+
+
+// Сортировка записей по вычисляемому ключу с кэшированием ключей (преобразование Шварца).
+//
+// Ключ каждой записи вычисляется ровно один раз, параллельно, в компактный массив пар
+// (ключ, исходный индекс). Сортируется этот массив, а не записи: числовые ключи до 32 бит
+// упаковываются вместе с индексом в одно 64-битное число и сортируются поразрядно,
+// остальные — обобщенной быстрой сортировкой по паре. Индекс служит вторым ключом, поэтому
+// сортировка устойчива. Затем записи параллельно переставляются по полученной перестановке
+// через временный буфер (каждая запись перемещается дважды, без копирования).
+// На той же основе — argsort (только перестановка) и синхронная сортировка массивов ключей и значений.
+
+namespace sort_by_key_detail {
+
+constexpr long grain = 1L << 14; // Минимальная часть для параллельных проходов
+
+// Ключ помещается в упакованное 64-битное представление вместе с 32-битным индексом
+template <typename K>
+inline constexpr bool packable_v = std::is_arithmetic_v<K> && !std::is_same_v<K, bool> && sizeof(K) <= 4;
+
+// Старшая половина упакованного представления. radix_key различает -0.0 и +0.0, а для "<" они
+// равны, поэтому ноль приводится к +0.0 и равные ключи сохраняют исходный порядок.
+// NaN (для "<" порядок с ними не определен) оказываются после +inf, упорядоченные по своим битам
+template <typename K>
+uint64_t packed_key(K key) {
+    if constexpr (std::is_floating_point_v<K>) {
+        if (key == K(0)) key = K(0);
+    }
+    return uint64_t(radix_key(key));
+}
+
+// Переставить [first, first + n) так, что на месте i окажется запись с индексом index(i)
+template <typename RandomIt, typename IndexFn>
+void apply_permutation(RandomIt first, long n, IndexFn index, ThreadPool &pool) {
+    using T = typename std::iterator_traits<RandomIt>::value_type;
+    std::allocator<T> alloc;
+    T* tmp = alloc.allocate(size_t(n));
+    parallel_for(pool, n, grain, [=](long b, long e) {
+        for (long i = b; i < e; ++i) std::construct_at(tmp + i, std::move(first[index(i)]));
+    });
+    parallel_for(pool, n, grain, [=](long b, long e) {
+        for (long i = b; i < e; ++i) {
+            first[i] = std::move(tmp[i]);
+            std::destroy_at(tmp + i);
+        }
+    });
+    alloc.deallocate(tmp, size_t(n));
+}
+
+// Устойчивый порядок индексов [0, n) по ключам key_at(i) в смысле comp.
+// Ключи вычисляются один раз; сортируются только ключи с индексами, а не сами записи
+template <typename KeyAt, typename Compare>
+std::vector<long> sorted_order(long n, KeyAt key_at, ThreadPool &pool, Compare comp) {
+    using K = std::remove_cvref_t<std::invoke_result_t<KeyAt &, long>>;
+    std::vector<long> order(std::max(n, 0L));
+    if (n < 2) {
+        if (n == 1) order[0] = 0;
+        return order;
+    }
+
+    constexpr bool ascending = std::is_same_v<Compare, std::less<>> || std::is_same_v<Compare, std::less<K>>;
+    if constexpr (packable_v<K> && ascending) {
+        if (uint64_t(n) <= UINT32_MAX) {
+            // Старшие 32 бита — ключ с сохранением порядка, младшие — индекс
+            std::vector<uint64_t> packed(n);
+            parallel_for(pool, n, grain, [&](long b, long e) {
+                for (long i = b; i < e; ++i) packed[i] = (packed_key(key_at(i)) << 32) | uint64_t(i);
+            });
+            // Индексы уже идут по возрастанию, а поразрядная сортировка устойчива: сортируются только биты ключа
+            radix_sort_async(pool, packed.data(), 0, n - 1, static_cast<uint64_t*>(nullptr), 8, 32).get();
+            parallel_for(pool, n, grain, [&](long b, long e) {
+                for (long i = b; i < e; ++i) order[i] = long(packed[i] & UINT32_MAX);
+            });
+            return order;
+        }
+    }
+
+    std::vector<std::pair<K, long>> keyed(n);
+    parallel_for(pool, n, grain, [&](long b, long e) {
+        for (long i = b; i < e; ++i) keyed[i] = {key_at(i), i};
+    });
+    parallel_sort(keyed.begin(), keyed.end(), [comp](const std::pair<K, long> &a, const std::pair<K, long> &b) {
+        if (comp(a.first, b.first)) return true;
+        if (comp(b.first, a.first)) return false;
+        return a.second < b.second;
+    }, pool);
+    parallel_for(pool, n, grain, [&](long b, long e) {
+        for (long i = b; i < e; ++i) order[i] = keyed[i].second;
+    });
+    return order;
+}
+
+} // namespace sort_by_key_detail
+
+// Отсортировать [first, last) по ключу key_fn(запись) в порядке comp (по умолчанию — по возрастанию).
+// key_fn вызывается ровно один раз для каждой записи и может выполняться в разных потоках.
+// Нельзя вызывать из задачи того же пула.
+template <typename RandomIt, typename KeyFn, typename Compare = std::less<>>
+void parallel_sort_by_key(RandomIt first, RandomIt last, KeyFn key_fn, ThreadPool &pool, Compare comp = {}) {
+    using namespace sort_by_key_detail;
+    long n = long(last - first);
+    if (n < 2) return;
+    auto order = sorted_order(n, [&](long i) { return std::invoke(key_fn, first[i]); }, pool, comp);
+    const long* p = order.data();
+    apply_permutation(first, n, [p](long i) { return p[i]; }, pool);
+}
+
+// То же для диапазона с произвольным доступом
+template <std::ranges::random_access_range Range, typename KeyFn, typename Compare = std::less<>>
+    requires std::ranges::common_range<Range>
+void parallel_sort_by_key(Range &&range, KeyFn key_fn, ThreadPool &pool, Compare comp = {}) {
+    parallel_sort_by_key(std::ranges::begin(range), std::ranges::end(range), std::move(key_fn), pool, std::move(comp));
+}
+
+// Устойчивая перестановка, упорядочивающая keys: keys[result[0]] <= keys[result[1]] <= ...
+template <std::ranges::random_access_range Keys, typename Compare = std::less<>>
+std::vector<long> parallel_argsort(const Keys &keys, ThreadPool &pool, Compare comp = {}) {
+    auto first = std::ranges::begin(keys);
+    return sort_by_key_detail::sorted_order(long(std::ranges::size(keys)), [first](long i) { return first[i]; },
+                                            pool, comp);
+}
+
+// Отсортировать keys и переставить values синхронно с ними (устойчиво).
+// Массивы хранятся раздельно: при сортировке перемещаются только ключи с индексами,
+// значения переставляются один раз в конце
+template <std::ranges::random_access_range Keys, std::ranges::random_access_range Values, typename Compare = std::less<>>
+    requires std::ranges::common_range<Keys> && std::ranges::common_range<Values>
+void parallel_sort_pairs(Keys &&keys, Values &&values, ThreadPool &pool, Compare comp = {}) {
+    using namespace sort_by_key_detail;
+    long n = long(std::ranges::size(keys));
+    if (long(std::ranges::size(values)) != n) throw std::invalid_argument("parallel_sort_pairs: размеры ключей и значений различаются");
+    if (n < 2) return;
+    auto order = parallel_argsort(keys, pool, comp);
+    const long* p = order.data();
+    apply_permutation(std::ranges::begin(keys), n, [p](long i) { return p[i]; }, pool);
+    apply_permutation(std::ranges::begin(values), n, [p](long i) { return p[i]; }, pool);
+}
@@ -0,0 +1,113 @@
+#pragma once
+#include <algorithm>
+#include <functional>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "ThreadPool.h"
+#include "Quicksort.h"
+#include "MergeSort.h"
+#include "RadixSort.h"
+#include "ParallelSort.h"
+
+
+
+// Контекст многократной сортировки массивов похожего размера на одном пуле.
+//
+// Владеет всем, что сортировка иначе выделяет в каждом вызове: буфером для слияния и поразрядной
+// сортировки, состоянием завершения (вместо promise — флаг, который ждет wait()), узлами дерева
+// слияния, гистограммами и буферами объединения записи поразрядной сортировки. Все это растет до
+// наибольшего встреченного размера и не освобождается, а кадры задач пула хранятся в самих задачах
+// и в кольцевых очередях пула. Поэтому повторный вызов с тем же размером не выделяет память.
+// Для тривиальных типов reserve() выделяет неинициализированный буфер, и первое обращение
+// к его страницам делают задачи пула.
+//
+// Одновременно выполняется не больше одной сортировки. Методы блокирующие:
+// нельзя вызывать из задачи того же пула.
+
+template <typename T>
+class SortContext {
+public:
+    explicit SortContext(ThreadPool &pool, long threshold = 100000)
+        : pool_(pool), threshold_(threshold), state_(std::make_shared<QuicksortState>()) {
+        state_->opts = parallel_sort_detail::default_options();
+    }
+
+    SortContext(const SortContext &) = delete;
+    SortContext &operator=(const SortContext &) = delete;
+
+    // Настройки быстрой сортировки (например, задание пула для справедливого планирования)
+    QuicksortOptions &options() { return state_->opts; }
+
+    // Выделить буфер не меньше чем на n элементов. Память тривиальных типов не инициализируется:
+    // страницы впервые заполняют задачи пула
+    void reserve(long n) {
+        if (n <= capacity_) return;
+        scratch_.reset(); // Старый буфер освобождается до выделения нового
+        capacity_ = 0;
+        scratch_.reset(new T[size_t(n)]);
+        capacity_ = n;
+        if constexpr (std::is_trivially_default_constructible_v<T>) {
+            T* p = scratch_.get();
+            parallel_for(pool_, n, 1L << 16, [p](long b, long e) { std::fill(p + b, p + e, T {}); });
+        }
+    }
+
+    // Текущий размер буфера, элементов
+    long capacity() const { return capacity_; }
+
+    // Быстрая сортировка [first, last)
+    template <typename Compare = std::less<>>
+    void sort(T* first, T* last, Compare comp = {}) {
+        long n = long(last - first);
+        if (n < 2) return;
+        state_->restart();
+        spawn_task_in_pool(pool_, state_, [this, first, n, comp]() {
+            quicksort_job(pool_, first, 0, n - 1, state_, threshold_, comp);
+        });
+        state_->wait();
+    }
+
+    // Устойчивая сортировка слиянием [first, last) через кэшированный буфер и узлы
+    template <typename Compare = std::less<>>
+    void stable_sort(T* first, T* last, Compare comp = {}) {
+        long n = long(last - first);
+        if (n < 2) return;
+        reserve(n);
+        state_->restart();
+        merge_sort_async(pool_, first, 0, n - 1, state_, merge_workspace<Compare>(), scratch_.get(), threshold_, comp);
+        state_->wait();
+    }
+
+    // Поразрядная сортировка LSD [first, last) через кэшированные буфер и гистограммы
+    // (для целых и чисел с плавающей точкой)
+    void radix_sort(T* first, T* last, int radix_bits = 8) {
+        long n = long(last - first);
+        if (n < 2) return;
+        reserve(n);
+        state_->restart();
+        radix_sort_async(pool_, first, 0, n - 1, state_, radix_ws_, scratch_.get(), radix_bits);
+        state_->wait();
+    }
+
+private:
+    // Память узлов слияния для компаратора Compare: создается при первом вызове с этим типом компаратора
+    template <typename Compare>
+    MergeWorkspace<T, Compare> &merge_workspace() {
+        static const char tag = 0;
+        for (auto &[key, ws] : merge_ws_) {
+            if (key == &tag) return *static_cast<MergeWorkspace<T, Compare>*>(ws.get());
+        }
+        merge_ws_.emplace_back(&tag, std::make_shared<MergeWorkspace<T, Compare>>());
+        return *static_cast<MergeWorkspace<T, Compare>*>(merge_ws_.back().second.get());
+    }
+
+    ThreadPool &pool_;
+    long threshold_;
+    std::shared_ptr<QuicksortState> state_;
+    std::unique_ptr<T[]> scratch_;
+    long capacity_ = 0;
+    std::vector<std::pair<const void*, std::shared_ptr<void>>> merge_ws_; // Тип компаратора -> память слияния
+    RadixWorkspace<T> radix_ws_;
+};
@@ -0,0 +1,128 @@
+#pragma once
+#include <algorithm>
+#include <functional>
+#include <future>
+#include <iterator>
+#include <memory>
+#include <vector>
+#include "ThreadPool.h"
+#include "ParallelSort.h"
+#include "LoserTree.h"
+
+
+
+// Потоковая сортировка: данные поступают порциями, каждая порция сортируется на пуле сразу
+// при поступлении, параллельно с приемом следующих. finish() дожидается сортировки всех порций
+// и сливает их параллельным k-путевым слиянием: выход делится на части значениями-разделителями
+// из выборки по всем порциям, границы частей в каждой порции находятся двоичным поиском,
+// и каждая часть сливается своей задачей пула через дерево проигравших.
+
+template <typename T, typename Compare = std::less<>>
+class StreamingSorter {
+public:
+    explicit StreamingSorter(ThreadPool &pool, Compare comp = {}, long threshold = 100000)
+        : pool_(pool), comp_(comp), threshold_(threshold) {}
+
+    // Дождаться сортировок, запущенных для уже принятых порций (их память должна жить до конца задач)
+    ~StreamingSorter() {
+        for (auto &f : sorting_) {
+            if (f.valid()) f.wait();
+        }
+    }
+
+    StreamingSorter(const StreamingSorter &) = delete;
+    StreamingSorter &operator=(const StreamingSorter &) = delete;
+
+    // Принять порцию и сразу запустить ее сортировку на пуле
+    void push(std::vector<T> chunk) {
+        if (chunk.empty()) return;
+        total_ += long(chunk.size());
+        chunks_.push_back(std::make_unique<std::vector<T>>(std::move(chunk)));
+        auto &c = *chunks_.back();
+        sorting_.push_back(parallel_sort_async(c.begin(), c.end(), comp_, pool_, threshold_));
+    }
+
+    template <typename InputIt>
+    void push(InputIt first, InputIt last) {
+        push(std::vector<T>(first, last));
+    }
+
+    // Принято элементов
+    long size() const { return total_; }
+
+    // Слить все порции в один отсортированный массив; после вызова сортировщик пуст.
+    // Нельзя вызывать из задачи того же пула
+    std::vector<T> finish() {
+        for (auto &f : sorting_) f.get();
+        sorting_.clear();
+        std::vector<T> out(total_);
+        if (total_ > 0) merge_into(out);
+        chunks_.clear();
+        total_ = 0;
+        return out;
+    }
+
+private:
+    static constexpr long min_piece = 1L << 16;
+    static constexpr long samples_per_piece = 32;
+
+    void merge_into(std::vector<T> &out) {
+        long k = long(chunks_.size());
+        long P = std::clamp(total_ / min_piece, 1L, long(pool_.size()));
+        // split[p * k + j] — начало части p в порции j
+        std::vector<long> split((P + 1) * k, 0);
+        for (long j = 0; j < k; ++j) split[P * k + j] = long(chunks_[j]->size());
+        if (P > 1) {
+            std::vector<T> sample;
+            for (auto &c : chunks_) {
+                long len = long(c->size());
+                long count = 1 + samples_per_piece * P * len / total_;
+                for (long s = 0; s < count; ++s) sample.push_back((*c)[s * len / count]);
+            }
+            std::sort(sample.begin(), sample.end(), comp_);
+            for (long p = 1; p < P; ++p) {
+                const T &splitter = sample[p * long(sample.size()) / P];
+                for (long j = 0; j < k; ++j) {
+                    auto &c = *chunks_[j];
+                    split[p * k + j] = long(std::lower_bound(c.begin(), c.end(), splitter, comp_) - c.begin());
+                }
+            }
+        }
+        std::vector<long> start(P + 1, 0);
+        for (long p = 0; p < P; ++p) {
+            long size = 0;
+            for (long j = 0; j < k; ++j) size += split[(p + 1) * k + j] - split[p * k + j];
+            start[p + 1] = start[p] + size;
+        }
+        parallel_for(pool_, P, 1, [&](long b, long e) {
+            for (long p = b; p < e; ++p) merge_piece(p, split, start[p], out);
+        });
+    }
+
+    // Слияние кусков всех порций, относящихся к части p, в out начиная с позиции dst
+    void merge_piece(long p, const std::vector<long> &split, long dst, std::vector<T> &out) {
+        long k = long(chunks_.size());
+        std::vector<long> pos(k), end(k);
+        for (long j = 0; j < k; ++j) {
+            pos[j] = split[p * k + j];
+            end[j] = split[(p + 1) * k + j];
+        }
+        auto beats = [&](long a, long b) {
+            if (pos[a] == end[a]) return false;
+            if (pos[b] == end[b]) return true;
+            return comp_((*chunks_[a])[pos[a]], (*chunks_[b])[pos[b]]);
+        };
+        LoserTree<decltype(beats)> tree(k, beats);
+        for (long w = tree.winner(); pos[w] < end[w]; w = tree.winner()) {
+            out[dst++] = std::move((*chunks_[w])[pos[w]++]);
+            tree.replay();
+        }
+    }
+
+    ThreadPool &pool_;
+    Compare comp_;
+    long threshold_;
+    long total_ = 0;
+    std::vector<std::unique_ptr<std::vector<T>>> chunks_;
+    std::vector<std::future<void>> sorting_;
+};
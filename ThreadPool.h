@@ -1,17 +1,198 @@
 #pragma once
+#include <algorithm>
 #include <atomic>
+#include <chrono>
 #include <condition_variable>
-#include <deque>
-#include <functional>
+#include <cstddef>
+#include <cstdint>
 #include <memory>
 #include <mutex>
 #include <thread>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
 
 
-// Тип задачи для пула потоков — функция без аргументов и возвращаемого значения
-using task_type = std::function<void()>;
+// Задача пула: функция без аргументов и возвращаемого значения, только перемещаемая.
+// Функциональный объект до inline_size байт (этого хватает задачам сортировок вместе с состоянием
+// завершения) хранится прямо в задаче, больший — в куче. Поэтому постановка задачи в очередь
+// в установившемся режиме не выделяет память
+class PoolTask {
+public:
+    static constexpr size_t inline_size = 112;
+
+    PoolTask() = default;
+
+    template <typename F, typename = std::enable_if_t<!std::is_same_v<std::decay_t<F>, PoolTask>>>
+    PoolTask(F &&f) {
+        using Fn = std::decay_t<F>;
+        if constexpr (sizeof(Fn) <= inline_size && alignof(Fn) <= alignof(std::max_align_t) &&
+                      std::is_nothrow_move_constructible_v<Fn>) {
+            ::new (static_cast<void*>(m_storage)) Fn(std::forward<F>(f));
+            m_ops = &inline_ops<Fn>;
+        } else {
+            *reinterpret_cast<Fn**>(m_storage) = new Fn(std::forward<F>(f));
+            m_ops = &heap_ops<Fn>;
+        }
+    }
+
+    PoolTask(PoolTask &&other) noexcept { take(other); }
+
+    PoolTask &operator=(PoolTask &&other) noexcept {
+        if (this != &other) {
+            reset();
+            take(other);
+        }
+        return *this;
+    }
+
+    ~PoolTask() { reset(); }
+
+    explicit operator bool() const { return m_ops != nullptr; }
+
+    void operator()() { m_ops->call(m_storage); }
+
+private:
+    struct Ops {
+        void (*call)(void*);
+        void (*move)(void* from, void* to); // Перенести объект и уничтожить источник
+        void (*destroy)(void*);
+    };
+
+    template <typename Fn>
+    static constexpr Ops inline_ops = {
+        [](void* p) { (*static_cast<Fn*>(p))(); },
+        [](void* from, void* to) {
+            ::new (to) Fn(std::move(*static_cast<Fn*>(from)));
+            static_cast<Fn*>(from)->~Fn();
+        },
+        [](void* p) { static_cast<Fn*>(p)->~Fn(); },
+    };
+
+    template <typename Fn>
+    static constexpr Ops heap_ops = {
+        [](void* p) { (**static_cast<Fn**>(p))(); },
+        [](void* from, void* to) { *static_cast<Fn**>(to) = *static_cast<Fn**>(from); },
+        [](void* p) { delete *static_cast<Fn**>(p); },
+    };
+
+    void take(PoolTask &other) {
+        if (!other.m_ops) return;
+        other.m_ops->move(other.m_storage, m_storage);
+        m_ops = std::exchange(other.m_ops, nullptr);
+    }
+
+    void reset() {
+        if (m_ops) std::exchange(m_ops, nullptr)->destroy(m_storage);
+    }
+
+    alignas(std::max_align_t) unsigned char m_storage[inline_size];
+    const Ops* m_ops = nullptr;
+};
+
+// Тип задачи для пула потоков
+using task_type = PoolTask;
+
+// Двусторонняя очередь на кольцевом буфере. Емкость только растет, поэтому добавление и извлечение
+// в установившемся режиме не выделяют память (std::deque выделяет и освобождает блоки на ходу).
+// Извлеченная ячейка сбрасывается, чтобы задача сразу освободила захваченные ресурсы
+template <typename T>
+class TaskRing {
+public:
+    bool empty() const { return m_size == 0; }
+
+    T &front() { return m_slots[m_head]; }
+    T &back() { return m_slots[(m_head + m_size - 1) & (m_slots.size() - 1)]; }
+
+    void push_front(T x) {
+        if (m_size == m_slots.size()) grow();
+        m_head = (m_head + m_slots.size() - 1) & (m_slots.size() - 1);
+        m_slots[m_head] = std::move(x);
+        ++m_size;
+    }
+
+    void pop_front() {
+        front() = T();
+        m_head = (m_head + 1) & (m_slots.size() - 1);
+        --m_size;
+    }
+
+    void pop_back() {
+        back() = T();
+        --m_size;
+    }
+
+    void clear() {
+        while (!empty()) pop_back();
+    }
+
+private:
+    void grow() {
+        std::vector<T> slots(std::max<size_t>(16, 2 * m_slots.size())); // Размер — степень двойки
+        for (size_t i = 0; i < m_size; ++i) slots[i] = std::move(m_slots[(m_head + i) & (m_slots.size() - 1)]);
+        m_slots.swap(slots);
+        m_head = 0;
+    }
+
+    std::vector<T> m_slots;
+    size_t m_head = 0;
+    size_t m_size = 0;
+};
+
+// Политика выбора задания, чья задача выполняется следующей
+enum class JobScheduling {
+    RoundRobin,   // Задания по очереди, по одной задаче
+    WeightedFair  // Задание с наименьшим временем выполнения, деленным на вес
+};
+
+// Снимок статистики задания
+struct PoolJobStats {
+    uint64_t tasks = 0;        // Выполнено задач
+    double queue_wait = 0;     // Суммарное ожидание задач в очереди, с
+    double max_queue_wait = 0; // Наибольшее ожидание одной задачи в очереди, с
+    double run_time = 0;       // Суммарное время выполнения задач, с
+
+    double average_queue_wait() const { return tasks ? queue_wait / double(tasks) : 0.0; }
+};
+
+// Задание пула: группа задач одного запроса (например, одной сортировки). Задачи заданий лежат
+// в отдельных очередях, и пул делит между заданиями потоки справедливо, чтобы задачи большого
+// задания не вытесняли маленькие. Задание используется только с одним пулом
+class PoolJob {
+public:
+    explicit PoolJob(unsigned weight = 1) : m_weight(std::max(1u, weight)) {}
+
+    PoolJob(const PoolJob &) = delete;
+    PoolJob &operator=(const PoolJob &) = delete;
+
+    unsigned weight() const { return m_weight; }
+
+    PoolJobStats stats() const {
+        PoolJobStats s;
+        s.tasks = m_tasks_done.load(std::memory_order_relaxed);
+        s.queue_wait = double(m_wait_ns.load(std::memory_order_relaxed)) * 1e-9;
+        s.max_queue_wait = double(m_max_wait_ns.load(std::memory_order_relaxed)) * 1e-9;
+        s.run_time = double(m_run_ns.load(std::memory_order_relaxed)) * 1e-9;
+        return s;
+    }
+
+private:
+    friend class ThreadPool;
+
+    struct Entry {
+        task_type task;
+        std::chrono::steady_clock::time_point enqueued;
+    };
+
+    unsigned m_weight;
+    TaskRing<Entry> m_queue; // Ожидающие задачи (под мьютексом заданий пула)
+    std::atomic<uint64_t> m_vtime {0}; // Время выполнения, деленное на вес (в единицах нс / 1024)
+    std::atomic<uint64_t> m_tasks_done {0};
+    std::atomic<uint64_t> m_wait_ns {0};
+    std::atomic<uint64_t> m_max_wait_ns {0};
+    std::atomic<uint64_t> m_run_ns {0};
+};
 
 // Класс пула потоков с поддержкой work stealing
 class ThreadPool {
@@ -37,6 +218,7 @@ public:
         m_done.store(true); // Устанавливаем флаг завершения
         for (auto &cv : m_queue_cvs) cv->notify_all(); // Пробуждаем все потоки
         for (auto &t : m_workers) if (t.joinable()) t.join(); // Дожидаемся завершения всех потоков
+        for (auto &job : m_active) job->m_queue.clear(); // Невыполненные задачи держат ссылки на свое задание
     }
 
     // Добавить задачу в пул потоков
@@ -49,6 +231,35 @@ public:
         m_queue_cvs[idx]->notify_one(); // Пробуждаем поток, ожидающий задачу
     }
 
+    // Добавить задачу задания job (без задания — как push_task(t))
+    void push_task(task_type t, const std::shared_ptr<PoolJob> &job) {
+        if (!job) {
+            push_task(std::move(t));
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> l(m_jobs_mutex);
+            if (job->m_queue.empty()) activate(job);
+            job->m_queue.push_front({std::move(t), std::chrono::steady_clock::now()}); // Как и в очередях потоков — LIFO
+            m_job_tasks.fetch_add(1, std::memory_order_relaxed);
+        }
+        size_t idx = m_index.fetch_add(1, std::memory_order_relaxed) % m_queues.size();
+        { std::lock_guard<std::mutex> l(*m_queue_mutexes[idx]); } // Поток не пропустит пробуждение между проверкой и ожиданием
+        m_queue_cvs[idx]->notify_one();
+    }
+
+    // Ждут ли выполнения задачи других заданий: долгой задаче задания стоит отдать поток планировщику
+    bool should_yield(const std::shared_ptr<PoolJob> &job) {
+        if (m_job_tasks.load(std::memory_order_relaxed) == 0) return false;
+        std::lock_guard<std::mutex> l(m_jobs_mutex);
+        return std::any_of(m_active.begin(), m_active.end(), [&](const auto &j) { return j != job; });
+    }
+
+    void set_job_scheduling(JobScheduling policy) { m_policy.store(policy, std::memory_order_relaxed); }
+
+    // Количество рабочих потоков
+    size_t size() const { return m_workers.size(); }
+
 private:
     // Основной цикл работы потока
     void worker_loop(size_t my_index) {
@@ -59,6 +270,8 @@ private:
                 task(); // Выполняем задачу
                 continue;
             }
+            // Затем задачи заданий: справедливо между заданиями
+            if (try_run_job_task()) continue;
             bool stolen = false;
             // Пытаемся украсть задачу из других очередей
             for (size_t i = 0; i < m_queues.size(); ++i) {
@@ -74,7 +287,7 @@ private:
             // Если задач нет, ждем появления новых
             std::unique_lock<std::mutex> lk(*m_queue_mutexes[my_index]);
             m_queue_cvs[my_index]->wait_for(lk, std::chrono::milliseconds(50), [&]() {
-                return !m_queues[my_index].empty() || m_done.load();
+                return !m_queues[my_index].empty() || m_job_tasks.load(std::memory_order_relaxed) > 0 || m_done.load();
             });
         }
     }
@@ -88,6 +301,53 @@ private:
         return true;
     }
 
+    // Сделать задание активным; его время подтягивается к наименьшему среди активных, чтобы
+    // новое задание не получило преимущество за весь период простоя (вызывается под m_jobs_mutex)
+    void activate(const std::shared_ptr<PoolJob> &job) {
+        if (!m_active.empty()) {
+            uint64_t min_vtime = UINT64_MAX;
+            for (auto &j : m_active) min_vtime = std::min(min_vtime, j->m_vtime.load(std::memory_order_relaxed));
+            if (job->m_vtime.load(std::memory_order_relaxed) < min_vtime) job->m_vtime.store(min_vtime, std::memory_order_relaxed);
+        }
+        m_active.push_back(job);
+    }
+
+    // Выбрать задание по политике, взять его задачу и выполнить со сбором статистики
+    bool try_run_job_task() {
+        if (m_job_tasks.load(std::memory_order_relaxed) == 0) return false;
+        std::shared_ptr<PoolJob> job;
+        PoolJob::Entry entry;
+        {
+            std::lock_guard<std::mutex> l(m_jobs_mutex);
+            if (m_active.empty()) return false;
+            size_t pick = 0;
+            if (m_policy.load(std::memory_order_relaxed) == JobScheduling::RoundRobin) {
+                pick = m_next_job++ % m_active.size();
+            } else {
+                for (size_t i = 1; i < m_active.size(); ++i) {
+                    if (m_active[i]->m_vtime.load(std::memory_order_relaxed) < m_active[pick]->m_vtime.load(std::memory_order_relaxed)) pick = i;
+                }
+            }
+            job = m_active[pick];
+            entry = std::move(job->m_queue.front());
+            job->m_queue.pop_front();
+            m_job_tasks.fetch_sub(1, std::memory_order_relaxed);
+            if (job->m_queue.empty()) m_active.erase(m_active.begin() + pick);
+        }
+        auto start = std::chrono::steady_clock::now();
+        entry.task();
+        auto end = std::chrono::steady_clock::now();
+        uint64_t wait = uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(start - entry.enqueued).count());
+        uint64_t run = uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count());
+        job->m_vtime.fetch_add((run >> 10) / job->m_weight + 1, std::memory_order_relaxed);
+        job->m_tasks_done.fetch_add(1, std::memory_order_relaxed);
+        job->m_wait_ns.fetch_add(wait, std::memory_order_relaxed);
+        job->m_run_ns.fetch_add(run, std::memory_order_relaxed);
+        uint64_t max_wait = job->m_max_wait_ns.load(std::memory_order_relaxed);
+        while (wait > max_wait && !job->m_max_wait_ns.compare_exchange_weak(max_wait, wait, std::memory_order_relaxed)) {}
+        return true;
+    }
+
     // Украсть задачу из чужой очереди (с конца)
     bool try_steal_from_queue(size_t idx, task_type &out) {
         std::lock_guard<std::mutex> l(*m_queue_mutexes[idx]);
@@ -98,10 +358,15 @@ private:
     }
 
 private:
-    std::vector<std::deque<task_type>> m_queues; // Очереди задач для каждого потока
+    std::vector<TaskRing<task_type>> m_queues; // Очереди задач для каждого потока
     std::vector<std::thread> m_workers; // Вектор рабочих потоков
     std::vector<std::unique_ptr<std::condition_variable>> m_queue_cvs; // Условные переменные для очередей
     std::vector<std::unique_ptr<std::mutex>> m_queue_mutexes; // Мьютексы для очередей
     std::atomic<size_t> m_index {0}; // Индекс для round-robin распределения задач
     std::atomic<bool> m_done; // Флаг завершения работы пула
+    std::mutex m_jobs_mutex; // Мьютекс очередей заданий и списка активных заданий
+    std::vector<std::shared_ptr<PoolJob>> m_active; // Задания с ожидающими задачами
+    size_t m_next_job = 0; // Следующее задание для RoundRobin
+    std::atomic<long> m_job_tasks {0}; // Ожидающих задач во всех заданиях
+    std::atomic<JobScheduling> m_policy {JobScheduling::WeightedFair}; // Политика выбора задания
 };
\ No newline at end of file
@@ -0,0 +1,81 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include "ThreadPool.h"
+#include "ParallelSort.h"
+
+
+
+// Параллельная проверка результата сортировки.
+//
+// first_unsorted ищет первую позицию, где нарушен порядок: массив делится на части задачами пула,
+// найденная позиция публикуется в общем атомарном минимуме, и части правее нее прекращают проверку.
+// multiset_checksum — сумма перемешанных хешей элементов по модулю 2^64: не зависит от порядка,
+// но меняется при потере, дублировании или искажении элемента, поэтому сравнение сумм до и после
+// сортировки проверяет, что набор элементов сохранился. Нельзя вызывать из задачи того же пула.
+
+namespace verify_detail {
+
+constexpr long grain = 1L << 16;  // Минимальная часть массива на задачу
+constexpr long check_every = 4096; // Как часто часть проверяет, не найдено ли нарушение левее
+
+// Финальное перемешивание splitmix64: соседние хеши дают независимые слагаемые
+inline uint64_t mix(uint64_t x) {
+    x += 0x9E3779B97F4A7C15ull;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+    return x ^ (x >> 31);
+}
+
+} // namespace verify_detail
+
+// Контрольная сумма набора элементов (без учета порядка)
+struct MultisetChecksum {
+    uint64_t sum = 0;
+    uint64_t count = 0;
+
+    bool operator==(const MultisetChecksum &) const = default;
+};
+
+// Индекс первого элемента, меньшего предыдущего в смысле comp, или -1, если [first, last) упорядочен
+template <typename RandomIt, typename Compare = std::less<>>
+long first_unsorted(RandomIt first, RandomIt last, ThreadPool &pool, Compare comp = {}) {
+    using namespace verify_detail;
+    long n = long(last - first);
+    std::atomic<long> found {n};
+    parallel_for(pool, n, grain, [&](long b, long e) {
+        for (long i = std::max(b, 1L); i < e; ++i) {
+            if ((i & (check_every - 1)) == 0 && found.load(std::memory_order_relaxed) < i) return;
+            if (comp(first[i], first[i - 1])) {
+                long cur = found.load(std::memory_order_relaxed);
+                while (i < cur && !found.compare_exchange_weak(cur, i, std::memory_order_relaxed)) {}
+                return;
+            }
+        }
+    });
+    long pos = found.load();
+    return pos == n ? -1 : pos;
+}
+
+// Упорядочен ли [first, last) в смысле comp
+template <typename RandomIt, typename Compare = std::less<>>
+bool verify_sorted(RandomIt first, RandomIt last, ThreadPool &pool, Compare comp = {}) {
+    return first_unsorted(first, last, pool, comp) < 0;
+}
+
+// Контрольная сумма набора элементов [first, last), не зависящая от их порядка
+template <typename RandomIt, typename Hash = std::hash<typename std::iterator_traits<RandomIt>::value_type>>
+MultisetChecksum multiset_checksum(RandomIt first, RandomIt last, ThreadPool &pool, Hash hash = {}) {
+    using namespace verify_detail;
+    long n = long(last - first);
+    std::atomic<uint64_t> total {0};
+    parallel_for(pool, n, grain, [&](long b, long e) {
+        uint64_t sum = 0;
+        for (long i = b; i < e; ++i) sum += mix(uint64_t(hash(first[i])));
+        total.fetch_add(sum, std::memory_order_relaxed);
+    });
+    return {total.load(), uint64_t(std::max(n, 0L))};
+}
@@ -0,0 +1,50 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#endif
+#include "ThreadPool.h"
+#include "RecordSort.h"
+
+
+
+// Генератор файла записей в формате gensort: gensort <число записей> <файл> [seed]
+int main(int argc, char** argv) {
+#ifdef _WIN32
+    SetConsoleOutputCP(65001); // Установить кодировку UTF-8 для корректного вывода на русском языке
+#endif
+    if (argc < 3) {
+        std::cerr << "Использование: gensort <число записей> <файл> [seed]" << std::endl;
+        return 2;
+    }
+    long n = std::strtol(argv[1], nullptr, 10);
+    uint64_t seed = argc > 3 ? std::strtoull(argv[3], nullptr, 10) : 0;
+    std::FILE* f = std::fopen(argv[2], "wb");
+    if (!f || n < 0) {
+        std::cerr << "Не удалось создать " << argv[2] << std::endl;
+        return 1;
+    }
+
+    ThreadPool pool;
+    constexpr long batch = 1L << 20; // Записей в одной порции (100 МБ)
+    std::vector<GensortRecord> records(std::min(n, batch));
+    uint64_t checksum = 0;
+    for (long row = 0; row < n; row += batch) {
+        long count = std::min(batch, n - row);
+        generate_records(records.data(), count, uint64_t(row), seed, pool);
+        checksum += check_records(records.data(), count, pool).checksum;
+        if (std::fwrite(records.data(), record_size, size_t(count), f) != size_t(count)) {
+            std::cerr << "Ошибка записи в " << argv[2] << std::endl;
+            std::fclose(f);
+            return 1;
+        }
+    }
+    std::fclose(f);
+    std::cout << "Записей: " << n << ", контрольная сумма: " << std::hex << checksum << std::endl;
+    return 0;
+}
@@ -1,5 +1,7 @@
 #include <atomic>
 #include <chrono>
+#include <cmath>
+#include <cstdlib>
 #include <ctime>
 #include <condition_variable>
 #include <functional>
@@ -7,118 +9,48 @@
 #include <iostream>
 #include <memory>
 #include <mutex>
+#include <new>
 #include <random>
 #include <thread>
 #include <vector>
 #include <deque>
 #include <algorithm>
 #include <exception>
+#define NOMINMAX // Макросы min/max из windows.h ломают std::min/std::max в заголовках сортировок
 #include <windows.h>
 #include "ThreadPool.h"
+#include "Quicksort.h"
+#include "Samplesort.h"
+#include "RadixSort.h"
+#include "MergeSort.h"
+#include "ParallelSort.h"
+#include "SortByKey.h"
+#include "CountingSort.h"
+#include "Presorted.h"
+#include "Selection.h"
+#include "Verify.h"
+#include "ExternalSort.h"
+#include "MmapSort.h"
+#include "StreamingSort.h"
+#include "ProgressiveSort.h"
+#include "LazySortedView.h"
+#include "SegmentedSort.h"
+#include "SortContext.h"
 
 
 
-// Структура для отслеживания состояния быстрой сортировки
-struct QuicksortState {
-    std::shared_ptr<std::promise<void>> prom; //  для ожидания завершения сортировки
-    std::shared_ptr<std::atomic<int>> counter; // Счетчик активных задач
-    std::shared_ptr<std::exception_ptr> except_ptr; // Указатель на исключение
-    std::shared_ptr<std::mutex> except_mtx; // Мьютекс для обработки исключений
-    std::shared_ptr<bool> except_set; // Флаг, что исключение уже установлено
-
-    QuicksortState()
-        : prom(std::make_shared<std::promise<void>>()),
-          counter(std::make_shared<std::atomic<int>>(0)),
-          except_ptr(std::make_shared<std::exception_ptr>()),
-          except_mtx(std::make_shared<std::mutex>()),
-          except_set(std::make_shared<bool>(false))
-    {}
-};
-
-// Запустить задачу сортировки в пуле потоков и увеличить счетчик активных задач
-void spawn_task_in_pool(ThreadPool &pool, std::shared_ptr<QuicksortState> state, task_type job) {
-    state->counter->fetch_add(1, std::memory_order_relaxed); // Увеличиваем счетчик задач
-    pool.push_task([state, job = std::move(job)]() mutable {
-        try {
-            job(); // Выполняем задачу сортировки
-        } catch(...) {
-            // Если возникло исключение, сохраняем его
-            std::lock_guard<std::mutex> l(*state->except_mtx);
-            if (!*state->except_set) {
-                *state->except_ptr = std::current_exception();
-                *state->except_set = true;
-            }
-        }
-        // Уменьшаем счетчик задач, если все задачи завершены — завершаем promise
-        int prev = state->counter->fetch_sub(1, std::memory_order_acq_rel);
-        if (prev == 1) {
-            std::lock_guard<std::mutex> l(*state->except_mtx);
-            if (*state->except_set) {
-                state->prom->set_exception(*state->except_ptr);
-            } else {
-                state->prom->set_value();
-            }
-        }
-    });
-}
+// Счетчик выделений памяти: демонстрация SortContext проверяет, что повторные сортировки не выделяют память.
+// noinline: иначе GCC после встраивания принимает пару malloc/free за несовпадающие new/free
+std::atomic<long> allocations {0};
 
-// Рекурсивная задача быстрой сортировки для пула потоков
-void quicksort_job(ThreadPool &pool, int* array, long left, long right, std::shared_ptr<QuicksortState> state, long threshold) {
-    const long tiny = 1000; // Порог для сортировки маленьких участков стандартным алгоритмом
-    if (left >= right) return;
-    if (right - left <= tiny) {
-        std::sort(array + left, array + right + 1); // Сортируем маленький участок
-        return;
-    }
-
-    // Разбиение массива
-    long l = left, r = right;
-    int pivot = array[(l + r) / 2];
-    do {
-        while (array[l] < pivot) ++l;
-        while (array[r] > pivot) --r;
-        if (l <= r) {
-            std::swap(array[l], array[r]);
-            ++l; --r;
-        }
-    } while (l <= r);
-
-    // Определяем, стоит ли запускать подзадачи параллельно
-    bool left_big = (r - left) > threshold;
-    bool right_big = (right - l) > threshold;
-
-    // Запускаем подзадачи в пуле потоков, если участок достаточно большой
-    if (left_big && right_big) {
-        spawn_task_in_pool(pool, state, [=, &pool]() {
-            quicksort_job(pool, array, left, r, state, threshold);
-        });
-        quicksort_job(pool, array, l, right, state, threshold);
-    } else if (left_big) {
-        spawn_task_in_pool(pool, state, [=, &pool]() {
-            quicksort_job(pool, array, left, r, state, threshold);
-        });
-        quicksort_job(pool, array, l, right, state, threshold);
-    } else if (right_big) {
-        spawn_task_in_pool(pool, state, [=, &pool]() {
-            quicksort_job(pool, array, l, right, state, threshold);
-        });
-        quicksort_job(pool, array, left, r, state, threshold);
-    } else {
-        // Если участок маленький, сортируем оба участка последовательно
-        quicksort_job(pool, array, left, r, state, threshold);
-        quicksort_job(pool, array, l, right, state, threshold);
-    }
+__attribute__((noinline)) void* operator new(size_t size) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
 }
 
-// Асинхронный запуск быстрой сортировки через пул потоков
-std::future<void> quicksort_async(ThreadPool &pool, int* array, long left, long right, long threshold = 100000) {
-    auto state = std::make_shared<QuicksortState>(); // Создаем объект состояния сортировки
-    // Запускаем корневую задачу сортировки
-    spawn_task_in_pool(pool, state, [=, &pool]() {
-        quicksort_job(pool, array, left, right, state, threshold);
-    });
-    return state->prom->get_future(); // Возвращаем future для ожидания завершения сортировки
-}
+__attribute__((noinline)) void operator delete(void* p) noexcept { std::free(p); }
+__attribute__((noinline)) void operator delete(void* p, size_t) noexcept { std::free(p); }
 
 int main() {
     SetConsoleOutputCP(65001); // Установить кодировку UTF-8 для корректного вывода на русском языке
@@ -127,6 +59,7 @@ int main() {
 
     int *arr1 = new int[N];
     int *arr2 = new int[N];
+    int *arr3 = new int[N];
     std::mt19937 rng(0); // Генератор случайных чисел
     std::uniform_int_distribution<int> dist(0, 1000000); // Диапазон случайных чисел
 
@@ -136,24 +69,375 @@ int main() {
         arr2[i] = arr1[i];
     }
 
+    // Проверка результата демонстрации: массив упорядочен и содержит те же элементы, что и arr2
+    auto sorted_ok = [&](const int* a, ThreadPool &pool) {
+        return verify_sorted(a, a + N, pool) && multiset_checksum(a, a + N, pool) == multiset_checksum(arr2, arr2 + N, pool);
+    };
+
     {
         // Сортировка с использованием пула потоков
         clock_t time_start = clock();
         ThreadPool pool;
-        auto fut = quicksort_async(pool, arr1, 0, N-1, 100000);
+        QuicksortOptions opts;
+#ifndef NDEBUG
+        PartitionStats stats;
+        opts.stats = &stats;
+#endif
+        auto fut = quicksort_async(pool, arr1, 0, N-1, 100000, opts);
         fut.wait(); // Ожидаем завершения сортировки
         clock_t time_end = clock();
         std::cout << "Время быстрой сортировки с пулом потоков: " << double(time_end - time_start) / double(CLOCKS_PER_SEC) << " с" << std::endl;
         try {
             fut.get();
-            std::cout << "Без ошибок!" << std::endl;
+            // Проверяем результат: порядок и сохранность набора элементов (arr2 пока не тронут)
+            if (!verify_sorted(arr1, arr1 + N, pool)) {
+                std::cout << "Массив не отсортирован!" << std::endl;
+            } else if (multiset_checksum(arr1, arr1 + N, pool) != multiset_checksum(arr2, arr2 + N, pool)) {
+                std::cout << "Набор элементов изменился!" << std::endl;
+            } else {
+                std::cout << "Без ошибок!" << std::endl;
+            }
         } catch(const std::exception& e) {
             std::cout << "Была ошибка: " << e.what() <<  std::endl;
         }
+#ifndef NDEBUG
+        std::cout << "Разбиений: " << stats.partitions << ", средний баланс: " << stats.average_balance()
+                  << ", худший баланс: " << stats.worst_balance / 1000.0
+                  << ", перекошенных (<10%): " << stats.skewed << std::endl;
+#endif
 
         
     }
 
+    // Сравнение ядер разбиения с циклом Хоара на тех же данных
+    for (PartitionKernel kernel : {PartitionKernel::Block, PartitionKernel::Simd}) {
+        std::copy(arr2, arr2 + N, arr3);
+        clock_t time_start = clock();
+        ThreadPool pool;
+        QuicksortOptions opts;
+        opts.kernel = kernel;
+        auto fut = quicksort_async(pool, arr3, 0, N-1, 100000, opts);
+        fut.wait();
+        clock_t time_end = clock();
+        if (kernel == PartitionKernel::Block) std::cout << "Время сортировки с блочным разбиением: ";
+        else std::cout << "Время сортировки с векторным разбиением (" << simd_partition_isa() << "): ";
+        std::cout << double(time_end - time_start) / double(CLOCKS_PER_SEC) << " с"
+                  << (sorted_ok(arr3, pool) ? "" : " (ошибка!)") << std::endl;
+    }
+
+    {
+        // Сортировка выборкой на том же пуле
+        std::copy(arr2, arr2 + N, arr3);
+        clock_t time_start = clock();
+        ThreadPool pool;
+        auto fut = samplesort_async(pool, arr3, 0, N-1, 100000);
+        fut.wait();
+        clock_t time_end = clock();
+        std::cout << "Время сортировки выборкой с пулом потоков: " << double(time_end - time_start) / double(CLOCKS_PER_SEC) << " с"
+                  << (sorted_ok(arr3, pool) ? "" : " (ошибка!)") << std::endl;
+    }
+
+    {
+        // Поразрядная сортировка LSD с внешним буфером
+        std::copy(arr2, arr2 + N, arr3);
+        std::vector<int> scratch(N);
+        clock_t time_start = clock();
+        ThreadPool pool;
+        auto fut = radix_sort_async(pool, arr3, 0, N-1, scratch.data());
+        fut.wait();
+        clock_t time_end = clock();
+        std::cout << "Время поразрядной сортировки с пулом потоков: " << double(time_end - time_start) / double(CLOCKS_PER_SEC) << " с"
+                  << (sorted_ok(arr3, pool) ? "" : " (ошибка!)") << std::endl;
+    }
+
+    {
+        // Поразрядная сортировка MSD на месте (без буфера на n элементов)
+        std::copy(arr2, arr2 + N, arr3);
+        clock_t time_start = clock();
+        ThreadPool pool;
+        auto fut = msd_radix_sort_async(pool, arr3, 0, N-1, 100000);
+        fut.wait();
+        clock_t time_end = clock();
+        std::cout << "Время поразрядной сортировки на месте с пулом потоков: " << double(time_end - time_start) / double(CLOCKS_PER_SEC) << " с"
+                  << (sorted_ok(arr3, pool) ? "" : " (ошибка!)") << std::endl;
+    }
+
+    {
+        // Устойчивая сортировка слиянием
+        std::copy(arr2, arr2 + N, arr3);
+        clock_t time_start = clock();
+        ThreadPool pool;
+        auto fut = merge_sort_async(pool, arr3, 0, N-1, 100000);
+        fut.wait();
+        clock_t time_end = clock();
+        std::cout << "Время устойчивой сортировки слиянием с пулом потоков: " << double(time_end - time_start) / double(CLOCKS_PER_SEC) << " с"
+                  << (sorted_ok(arr3, pool) ? "" : " (ошибка!)") << std::endl;
+    }
+
+    {
+        // Сортировка подсчетом: диапазон значений демонстрационного массива не больше его размера
+        std::copy(arr2, arr2 + N, arr3);
+        clock_t time_start = clock();
+        ThreadPool pool;
+        auto fut = counting_sort_async(pool, arr3, 0, N-1, 100000);
+        fut.wait();
+        clock_t time_end = clock();
+        std::cout << "Время сортировки подсчетом с пулом потоков: " << double(time_end - time_start) / double(CLOCKS_PER_SEC) << " с" << std::endl;
+    }
+
+    {
+        // Распознавание упорядоченности: массив из четырех отсортированных серий сливается без сортировки
+        std::copy(arr2, arr2 + N, arr3);
+        for (long r = 0; r < 4; ++r) std::sort(arr3 + r * N / 4, arr3 + (r + 1) * N / 4);
+        clock_t time_start = clock();
+        ThreadPool pool;
+        auto fut = presorted_sort_async(pool, arr3, 0, N-1, 100000);
+        fut.wait();
+        clock_t time_end = clock();
+        std::cout << "Время сортировки массива из 4 серий: " << double(time_end - time_start) / double(CLOCKS_PER_SEC) << " с"
+                  << (sorted_ok(arr3, pool) ? "" : " (ошибка!)") << std::endl;
+    }
+
+    {
+        // Выбор медианы без полной сортировки
+        std::copy(arr2, arr2 + N, arr3);
+        clock_t time_start = clock();
+        ThreadPool pool;
+        auto fut = nth_element_async(pool, arr3, 0, N-1, N / 2);
+        fut.wait();
+        clock_t time_end = clock();
+        std::cout << "Медиана: " << arr3[N / 2] << ", время выбора: " << double(time_end - time_start) / double(CLOCKS_PER_SEC) << " с" << std::endl;
+    }
+
+    {
+        // Внешняя сортировка файла с бюджетом памяти в 1 МБ (много серий и слияние)
+        namespace fs = std::filesystem;
+        fs::path path = fs::temp_directory_path() / "quicksort_external_demo.bin";
+        if (std::FILE* f = std::fopen(path.string().c_str(), "wb")) {
+            std::fwrite(arr2, sizeof(int), N, f);
+            std::fclose(f);
+        }
+        ThreadPool pool;
+        ExternalSortOptions ext;
+        ext.memory_budget = size_t(1) << 20;
+        ext.io_buffer = size_t(64) << 10;
+        auto t_start = std::chrono::steady_clock::now();
+        external_sort<int>(path, path, pool, ext);
+        auto t_end = std::chrono::steady_clock::now();
+        if (std::FILE* f = std::fopen(path.string().c_str(), "rb")) {
+            std::fread(arr3, sizeof(int), N, f);
+            std::fclose(f);
+        }
+        fs::remove(path);
+        std::cout << "Время внешней сортировки файла: " << std::chrono::duration<double>(t_end - t_start).count() << " с"
+                  << (verify_sorted(arr3, arr3 + N, pool) ? "" : " (ошибка!)") << std::endl;
+    }
+
+    {
+        // Сортировка файла на месте через отображение в память (без копирования в буфер)
+        namespace fs = std::filesystem;
+        fs::path path = fs::temp_directory_path() / "quicksort_mmap_demo.bin";
+        if (std::FILE* f = std::fopen(path.string().c_str(), "wb")) {
+            std::fwrite(arr2, sizeof(int), N, f);
+            std::fclose(f);
+        }
+        ThreadPool pool;
+        auto t_start = std::chrono::steady_clock::now();
+        mmap_sort<int>(path, pool);
+        auto t_end = std::chrono::steady_clock::now();
+        bool sorted = false;
+        {
+            MappedFile file(path);
+            const int* data = static_cast<const int*>(file.data());
+            sorted = verify_sorted(data, data + file.size() / sizeof(int), pool);
+        }
+        fs::remove(path);
+        std::cout << "Время сортировки отображенного файла: " << std::chrono::duration<double>(t_end - t_start).count() << " с"
+                  << (sorted ? "" : " (ошибка!)") << std::endl;
+    }
+
+    {
+        // Потоковая сортировка: массив поступает 10 порциями, каждая сортируется сразу при поступлении
+        clock_t time_start = clock();
+        ThreadPool pool;
+        StreamingSorter<int> sorter(pool);
+        for (long c = 0; c < 10; ++c) sorter.push(arr2 + c * N / 10, arr2 + (c + 1) * N / 10);
+        std::vector<int> merged = sorter.finish();
+        clock_t time_end = clock();
+        std::cout << "Время потоковой сортировки (10 порций): " << double(time_end - time_start) / double(CLOCKS_PER_SEC) << " с"
+                  << (verify_sorted(merged.begin(), merged.end(), pool) ? "" : " (ошибка!)") << std::endl;
+    }
+
+    {
+        // Постепенная сортировка: первая десятая часть доступна раньше окончания всей сортировки
+        std::vector<int> values(arr2, arr2 + N);
+        QuicksortOptions opts;
+        opts.kernel = PartitionKernel::Simd;
+        auto time_start = std::chrono::steady_clock::now();
+        ThreadPool pool;
+        ProgressiveSort sorting = progressive_sort_async(pool, values.data(), 0, N - 1, 100000, opts);
+        sorting.progress->wait_for(N / 10);
+        auto time_prefix = std::chrono::steady_clock::now();
+        sorting.done.get();
+        auto time_end = std::chrono::steady_clock::now();
+        std::cout << "Постепенная сортировка: первые 10% через " << std::chrono::duration<double>(time_prefix - time_start).count()
+                  << " с, весь массив через " << std::chrono::duration<double>(time_end - time_start).count() << " с"
+                  << (verify_sorted(values.begin(), values.end(), pool) ? "" : " (ошибка!)") << std::endl;
+    }
+
+    {
+        // Ленивая сортировка: процентили и один диапазон без сортировки всего массива
+        std::copy(arr2, arr2 + N, arr3);
+        clock_t time_start = clock();
+        ThreadPool pool;
+        LazySortedView view(arr3, arr3 + N, pool);
+        int p10 = view.at(N / 10), p50 = view.at(N / 2), p90 = view.at(N * 9 / 10);
+        auto top = view.range(N - 1000, N);
+        clock_t time_end = clock();
+        std::cout << "Процентили 10/50/90: " << p10 << "/" << p50 << "/" << p90 << ", максимум: " << top.back()
+                  << ", участков: " << view.segments() << ", время: " << double(time_end - time_start) / double(CLOCKS_PER_SEC) << " с" << std::endl;
+    }
+
+    {
+        // Сортировка участков: массив делится на короткие независимые массивы от 10 до 10000 элементов
+        std::copy(arr2, arr2 + N, arr3);
+        std::vector<long> offsets {0};
+        while (offsets.back() < N) offsets.push_back(std::min(N, offsets.back() + 10 + long(rng() % 9991)));
+        clock_t time_start = clock();
+        ThreadPool pool;
+        segmented_sort(arr3, offsets, pool);
+        clock_t time_end = clock();
+        // Каждый участок упорядочен, и набор элементов всего буфера не изменился
+        bool ok = multiset_checksum(arr3, arr3 + N, pool) == multiset_checksum(arr2, arr2 + N, pool);
+        for (size_t i = 0; ok && i + 1 < offsets.size(); ++i) ok = std::is_sorted(arr3 + offsets[i], arr3 + offsets[i + 1]);
+        std::cout << "Время сортировки " << offsets.size() - 1 << " участков: " << double(time_end - time_start) / double(CLOCKS_PER_SEC) << " с"
+                  << (ok ? "" : " (ошибка!)") << std::endl;
+    }
+
+    {
+        // Несколько сортировок на одном пуле: большое задание и восемь маленьких делят потоки справедливо
+        std::copy(arr2, arr2 + N, arr3);
+        std::vector<std::vector<int>> small(8, std::vector<int>(arr2, arr2 + N / 20));
+        ThreadPool pool;
+        QuicksortOptions big_opts;
+        big_opts.job = std::make_shared<PoolJob>();
+        auto big = quicksort_async(pool, arr3, 0, N-1, 10000, big_opts);
+        std::vector<std::shared_ptr<PoolJob>> jobs;
+        std::vector<std::future<void>> small_sorts;
+        for (auto &v : small) {
+            QuicksortOptions opts;
+            opts.job = std::make_shared<PoolJob>();
+            jobs.push_back(opts.job);
+            small_sorts.push_back(quicksort_async(pool, v.data(), 0, long(v.size()) - 1, 10000, opts));
+        }
+        for (auto &f : small_sorts) f.get();
+        big.get();
+        double worst_wait = 0;
+        for (auto &job : jobs) worst_wait = std::max(worst_wait, job->stats().max_queue_wait);
+        PoolJobStats big_stats = big_opts.job->stats();
+        std::cout << "Большое задание: задач " << big_stats.tasks << ", среднее ожидание " << big_stats.average_queue_wait()
+                  << " с; маленькие: наибольшее ожидание задачи " << worst_wait << " с" << std::endl;
+    }
+
+    {
+        // Повторные сортировки через один контекст: быстрая, слиянием и поразрядная по очереди.
+        // Первый круг прогревает буферы контекста и очереди пула, второй не должен выделять память
+        ThreadPool pool;
+        SortContext<int> context(pool);
+        context.reserve(N / 10);
+        bool ok = true;
+        long round_allocations = 0;
+        double seconds = 0;
+        for (int round = 0; round < 2; ++round) {
+            round_allocations = 0;
+            clock_t time_start = clock();
+            for (long r = 0; r < 10; ++r) {
+                std::copy(arr2 + r * N / 10, arr2 + (r + 1) * N / 10, arr3);
+                long before = allocations.load();
+                if (r % 3 == 0) context.sort(arr3, arr3 + N / 10);
+                else if (r % 3 == 1) context.stable_sort(arr3, arr3 + N / 10);
+                else context.radix_sort(arr3, arr3 + N / 10);
+                round_allocations += allocations.load() - before;
+                ok = ok && verify_sorted(arr3, arr3 + N / 10, pool);
+            }
+            seconds = double(clock() - time_start) / double(CLOCKS_PER_SEC);
+        }
+        std::cout << "Время 10 сортировок с общим контекстом: " << seconds << " с, выделений памяти: " << round_allocations
+                  << (ok && round_allocations == 0 ? "" : " (ошибка!)") << std::endl;
+    }
+
+    {
+        // Обобщенная сортировка: вектор double по убыванию с пользовательским компаратором
+        std::vector<double> values(arr2, arr2 + N);
+        clock_t time_start = clock();
+        ThreadPool pool;
+        parallel_sort(values.begin(), values.end(), [](double a, double b) { return a > b; }, pool);
+        clock_t time_end = clock();
+        std::cout << "Время обобщенной сортировки (double, по убыванию): " << double(time_end - time_start) / double(CLOCKS_PER_SEC) << " с" << std::endl;
+    }
+
+    {
+        // Сортировка записей по ключу: ключ вычисляется один раз, равные ключи сохраняют исходный порядок
+        std::vector<std::pair<int, long>> records(N);
+        for (long i = 0; i < N; ++i) records[i] = {arr2[i] % 1000, i};
+        clock_t time_start = clock();
+        ThreadPool pool;
+        parallel_sort_by_key(records, [](const std::pair<int, long> &r) { return r.first; }, pool);
+        clock_t time_end = clock();
+        bool stable = verify_sorted(records.begin(), records.end(), pool); // Пары сравниваются по ключу, затем по номеру
+        // Вещественные ключи с -0.0 и +0.0: для "<" нули равны и должны сохранить исходный порядок,
+        // поэтому результат совпадает с std::stable_sort
+        std::vector<std::pair<float, long>> zeros(N);
+        for (long i = 0; i < N; ++i) {
+            float key = float(arr2[i] % 201 - 100) / 4;
+            zeros[i] = {key == 0 && (i & 1) ? -0.0f : key, i};
+        }
+        auto expected = zeros;
+        std::stable_sort(expected.begin(), expected.end(), [](const auto &a, const auto &b) { return a.first < b.first; });
+        parallel_sort_by_key(zeros, [](const std::pair<float, long> &r) { return r.first; }, pool);
+        stable = stable && std::equal(zeros.begin(), zeros.end(), expected.begin(),
+                                      [](const auto &a, const auto &b) { return a.second == b.second; });
+        std::cout << "Время сортировки записей по ключу: " << double(time_end - time_start) / double(CLOCKS_PER_SEC) << " с"
+                  << (stable ? "" : " (ошибка!)") << std::endl;
+    }
+
+    {
+        // Перестановка сортировки (argsort) и синхронная сортировка ключей и значений
+        std::vector<int> keys(arr2, arr2 + N);
+        std::vector<long> values(N);
+        for (long i = 0; i < N; ++i) values[i] = i;
+        clock_t time_start = clock();
+        ThreadPool pool;
+        std::vector<long> order = parallel_argsort(keys, pool);
+        parallel_sort_pairs(keys, values, pool);
+        clock_t time_end = clock();
+        // order — перестановка, упорядочивающая ключи; values ушли вместе со своими ключами
+        std::vector<char> seen(N, 0);
+        bool ok = long(order.size()) == N;
+        for (long i = 0; ok && i < N; ++i) {
+            ok = order[i] >= 0 && order[i] < N && !seen[order[i]] && order[i] == values[i] && arr2[values[i]] == keys[i];
+            if (ok) seen[order[i]] = 1;
+            if (ok && i > 0) ok = arr2[order[i - 1]] <= arr2[order[i]];
+        }
+        // Вещественные ключи с повторами, -0.0 и +0.0: перестановка и порядок значений совпадают с std::stable_sort
+        std::vector<float> fkeys(N);
+        for (long i = 0; i < N; ++i) {
+            float key = float(arr2[i] % 101 - 50) / 8;
+            fkeys[i] = key == 0 && (i & 1) ? -0.0f : key;
+        }
+        std::vector<long> expected(N);
+        for (long i = 0; i < N; ++i) expected[i] = i;
+        std::stable_sort(expected.begin(), expected.end(), [&](long a, long b) { return fkeys[a] < fkeys[b]; });
+        std::vector<float> fsorted = fkeys;
+        for (long i = 0; i < N; ++i) values[i] = i;
+        ok = ok && parallel_argsort(fkeys, pool) == expected;
+        parallel_sort_pairs(fsorted, values, pool);
+        ok = ok && values == expected;
+        for (long i = 0; ok && i < N; ++i) ok = std::signbit(fsorted[i]) == std::signbit(fkeys[expected[i]]);
+        std::cout << "Время argsort и сортировки пар: " << double(time_end - time_start) / double(CLOCKS_PER_SEC) << " с"
+                  << (ok ? "" : " (ошибка!)") << std::endl;
+    }
+
     {
         // Последовательная сортировка стандартным алгоритмом
         clock_t time_start = clock();
@@ -166,5 +450,6 @@ int main() {
     // Освобождаем память
     delete [] arr1;
     delete [] arr2;
+    delete [] arr3;
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,60 @@
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <iostream>
+#include <vector>
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#endif
+#include "ThreadPool.h"
+#include "RecordSort.h"
+
+
+
+// Сортировка файла записей gensort в памяти с замером времени: recsort <вход> <выход>
+int main(int argc, char** argv) {
+#ifdef _WIN32
+    SetConsoleOutputCP(65001); // Установить кодировку UTF-8 для корректного вывода на русском языке
+#endif
+    if (argc < 3) {
+        std::cerr << "Использование: recsort <вход> <выход>" << std::endl;
+        return 2;
+    }
+    std::error_code ec;
+    uintmax_t bytes = std::filesystem::file_size(argv[1], ec);
+    if (ec || bytes % record_size != 0) {
+        std::cerr << "Не удалось открыть " << argv[1] << " или размер не кратен " << record_size << " байтам" << std::endl;
+        return 1;
+    }
+    std::FILE* in = std::fopen(argv[1], "rb");
+    if (!in) {
+        std::cerr << "Не удалось открыть " << argv[1] << std::endl;
+        return 1;
+    }
+    // Буфер на весь файл — в куче, одним чтением
+    std::vector<GensortRecord> records(size_t(bytes / record_size));
+    size_t got = std::fread(records.data(), record_size, records.size(), in);
+    std::fclose(in);
+    if (got != records.size()) {
+        std::cerr << "Ошибка чтения " << argv[1] << std::endl;
+        return 1;
+    }
+
+    ThreadPool pool;
+    auto time_start = std::chrono::steady_clock::now();
+    sort_records(records.data(), long(records.size()), pool);
+    auto time_end = std::chrono::steady_clock::now();
+
+    std::FILE* out = std::fopen(argv[2], "wb");
+    if (!out || std::fwrite(records.data(), record_size, records.size(), out) != records.size()) {
+        std::cerr << "Ошибка записи в " << argv[2] << std::endl;
+        if (out) std::fclose(out);
+        return 1;
+    }
+    std::fclose(out);
+    double seconds = std::chrono::duration<double>(time_end - time_start).count();
+    std::cout << "Записей: " << records.size() << ", время сортировки: " << seconds << " с ("
+              << double(records.size()) * record_size / seconds / 1e6 << " МБ/с)" << std::endl;
+    return 0;
+}
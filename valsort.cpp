@@ -0,0 +1,62 @@
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#endif
+#include "ThreadPool.h"
+#include "RecordSort.h"
+
+
+
+// Проверка файла записей gensort: valsort <файл> [ожидаемая контрольная сумма (hex)]
+int main(int argc, char** argv) {
+#ifdef _WIN32
+    SetConsoleOutputCP(65001); // Установить кодировку UTF-8 для корректного вывода на русском языке
+#endif
+    if (argc < 2) {
+        std::cerr << "Использование: valsort <файл> [контрольная сумма]" << std::endl;
+        return 2;
+    }
+    std::FILE* f = std::fopen(argv[1], "rb");
+    if (!f) {
+        std::cerr << "Не удалось открыть " << argv[1] << std::endl;
+        return 1;
+    }
+
+    // Файл читается порциями; порядок проверяется и на стыке порций
+    ThreadPool pool;
+    constexpr long batch = 1L << 20;
+    std::vector<GensortRecord> records(batch + 1);
+    RecordCheck total;
+    long loaded = 0; // Записей в буфере, включая последнюю запись предыдущей порции
+    long offset = 0; // Номер первой записи буфера в файле
+    size_t got;
+    while ((got = std::fread(records.data() + loaded, record_size, size_t(batch), f)) > 0) {
+        long count = loaded + long(got);
+        RecordCheck part = check_records(records.data(), count, pool);
+        uint64_t carried = loaded ? uint64_t(check_records(records.data(), 1, pool).checksum) : 0;
+        total.records += long(got);
+        total.unsorted += part.unsorted;
+        total.duplicates += part.duplicates;
+        total.checksum += part.checksum - carried;
+        if (total.first_unsorted < 0 && part.first_unsorted >= 0) total.first_unsorted = offset + part.first_unsorted;
+        records[0] = records[count - 1];
+        offset += count - 1;
+        loaded = 1;
+    }
+    std::fclose(f);
+
+    std::cout << "Записей: " << total.records << ", повторяющихся ключей: " << total.duplicates
+              << ", контрольная сумма: " << std::hex << total.checksum << std::dec << std::endl;
+    bool ok = total.sorted();
+    if (!ok) std::cout << "Нарушений порядка: " << total.unsorted << ", первое на записи " << total.first_unsorted << std::endl;
+    if (argc > 2 && std::strtoull(argv[2], nullptr, 16) != total.checksum) {
+        std::cout << "Контрольная сумма не совпадает с ожидаемой" << std::endl;
+        ok = false;
+    }
+    std::cout << (ok ? "УСПЕХ" : "ОШИБКА") << std::endl;
+    return ok ? 0 : 1;
+}